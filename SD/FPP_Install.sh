@@ -370,7 +370,7 @@ case "${OSVER}" in
 			debian_9)
 				PACKAGE_LIST="alsa-base alsa-utils arping avahi-daemon \
 								apache2 apache2-bin apache2-data apache2-utils libapache2-mod-php7.0 \
-								zlib1g-dev libpcre3 libpcre3-dev libbz2-dev libssl-dev \
+								zlib1g-dev liblz4-dev libpcre3 libpcre3-dev libbz2-dev libssl-dev \
 								avahi-discover avahi-utils bash-completion bc btrfs-tools build-essential \
 								bzip2 ca-certificates ccache connman curl device-tree-compiler \
 								dh-autoreconf ethtool exfat-fuse fbi fbset file flite gdb \
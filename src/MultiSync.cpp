@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <linux/version.h>
@@ -41,6 +42,8 @@
 
 
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -67,6 +70,8 @@
 MultiSync *multiSync;
 
 static const char * MULTISYNC_MULTICAST_ADDRESS = "239.70.80.80"; // 239.F.P.P
+// room for the output ranges string in a v2 ping packet, without the null
+static const int MULTISYNC_PING_RANGES_LEN = 40;
 
 /*
  *
@@ -78,7 +83,9 @@ MultiSync::MultiSync()
 	m_receiveSock(-1),
     m_lastMediaHalfSecond(0),
 	m_remoteOffset(0.0),
-    m_numLocalSystems(0)
+    m_numLocalSystems(0),
+	m_sparseThread(nullptr),
+	m_sparseRunning(false)
 {
 	pthread_mutex_init(&m_systemsLock, NULL);
 	pthread_mutex_init(&m_socketLock, NULL);
@@ -91,6 +98,14 @@ MultiSync::~MultiSync()
 {
 	ShutdownSync();
 
+	std::unique_lock<std::mutex> lock(m_sparseLock);
+	m_sparseQueue.clear();
+	lock.unlock();
+	if (m_sparseThread) {
+		m_sparseThread->join();
+		delete m_sparseThread;
+	}
+
 	pthread_mutex_destroy(&m_systemsLock);
 	pthread_mutex_destroy(&m_socketLock);
 }
@@ -376,18 +391,7 @@ Json::Value MultiSync::GetSystems(bool localOnly, bool timestamps)
 
     int max = localOnly ? m_numLocalSystems : m_systems.size();
     
-    const std::vector<std::pair<uint32_t, uint32_t>> &ranges = GetOutputRanges();
-    bool first = true;
-    std::string range;
-    for (auto &a : ranges) {
-        if (!first) {
-            range += ",";
-        }
-        char buf[64];
-        sprintf(buf, "%d-%d", a.first, (a.first + a.second - 1));
-        range += buf;
-        first = false;
-    }
+    std::string range = GetRangesString();
 
     
 	for (int i = 0; i < max; i++) {
@@ -425,6 +429,148 @@ Json::Value MultiSync::GetSystems(bool localOnly, bool timestamps)
 	return result;
 }
 
+/*
+ * Write a sparse copy of a sequence for each remote with only the channels
+ * the remote reported it outputs.  The copies are named <name>-<hostname>.fseq
+ * so CheckForHostSpecificFile on the remote uses them instead of the full
+ * sequence.  Returns the number of files written.
+ */
+int MultiSync::GenerateRemoteSparseSequences(const std::string &sequence)
+{
+    std::vector<std::pair<std::string, std::string>> remotes;
+
+    pthread_mutex_lock(&m_systemsLock);
+    for (int i = m_numLocalSystems; i < m_systems.size(); i++) {
+        if ((m_systems[i].fppMode == REMOTE_MODE) &&
+            (!m_systems[i].hostname.empty()) &&
+            (!m_systems[i].ranges.empty())) {
+            remotes.push_back(std::pair<std::string, std::string>(m_systems[i].hostname, m_systems[i].ranges));
+        }
+    }
+    pthread_mutex_unlock(&m_systemsLock);
+
+    std::string seqDir = getSequenceDirectory();
+    std::string srcName = seqDir + "/" + sequence;
+    std::string baseName = sequence;
+    if (boost::iends_with(baseName, ".fseq"))
+        baseName = baseName.substr(0, baseName.length() - 5);
+
+    struct stat srcStat;
+    if (stat(srcName.c_str(), &srcStat)) {
+        LogErr(VB_SYNC, "Sequence %s does not exist\n", srcName.c_str());
+        return 0;
+    }
+    std::unique_ptr<FSEQFile> src(FSEQFile::openFSEQFile(srcName));
+    if (!src) {
+        LogErr(VB_SYNC, "Could not open sequence %s\n", srcName.c_str());
+        return 0;
+    }
+
+    int count = 0;
+    for (auto &remote : remotes) {
+        std::vector<std::pair<uint32_t, uint32_t>> ranges = ParseChannelRanges(remote.second);
+        if (ranges.empty())
+            continue;
+
+        std::string destName = seqDir + "/" + baseName + "-" + remote.first + ".fseq";
+        struct stat destStat;
+        if (!stat(destName.c_str(), &destStat) && (destStat.st_mtime >= srcStat.st_mtime)) {
+            // the remote's channels may have changed since the copy was made
+            std::vector<std::pair<uint32_t, uint32_t>> clipped = ranges;
+            Sequence::ClipSparseRanges(src.get(), clipped);
+
+            std::unique_ptr<FSEQFile> dest(FSEQFile::openFSEQFile(destName));
+            if (dest && (dest->getVersionMajor() >= 2) &&
+                (((V2FSEQFile*)dest.get())->m_sparseRanges == clipped)) {
+                LogDebug(VB_SYNC, "%s is up to date\n", destName.c_str());
+                continue;
+            }
+        }
+
+        LogInfo(VB_SYNC, "Creating %s with channels %s\n", destName.c_str(), remote.second.c_str());
+        if (Sequence::WriteSparseSequence(srcName, destName, ranges, FSEQFile::CompressionType::zstd))
+            count++;
+    }
+
+    return count;
+}
+
+/*
+ * Queue a sequence for GenerateRemoteSparseSequences.  This can take a
+ * while for large sequences so the queue is worked through one sequence
+ * at a time on a background thread.
+ */
+void MultiSync::QueueRemoteSparseSequences(const std::string &sequence)
+{
+    std::unique_lock<std::mutex> lock(m_sparseLock);
+
+    if (std::find(m_sparseQueue.begin(), m_sparseQueue.end(), sequence) != m_sparseQueue.end())
+        return;
+
+    m_sparseQueue.push_back(sequence);
+
+    if (!m_sparseRunning) {
+        // the previous thread has finished with the queue, reap it
+        if (m_sparseThread) {
+            m_sparseThread->join();
+            delete m_sparseThread;
+        }
+        m_sparseRunning = true;
+        m_sparseThread = new std::thread(&MultiSync::RemoteSparseSequencesLoop, this);
+    }
+}
+
+void MultiSync::RemoteSparseSequencesLoop(void)
+{
+    std::unique_lock<std::mutex> lock(m_sparseLock);
+
+    while (!m_sparseQueue.empty()) {
+        std::string sequence = m_sparseQueue.front();
+        m_sparseQueue.pop_front();
+        lock.unlock();
+
+        GenerateRemoteSparseSequences(sequence);
+
+        lock.lock();
+    }
+
+    m_sparseRunning = false;
+}
+
+/*
+ * Comma separated list of the output channel ranges as first-last.  If the
+ * list is longer than maxLen, the closest ranges are merged until it fits so
+ * the ranges are never cut off.
+ */
+std::string MultiSync::GetRangesString(size_t maxLen)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> ranges = GetOutputRanges();
+    while (true) {
+        std::string range;
+        for (auto &a : ranges) {
+            if (!range.empty()) {
+                range += ",";
+            }
+            char buf[64];
+            sprintf(buf, "%d-%d", a.first, (a.first + a.second - 1));
+            range += buf;
+        }
+        if ((range.length() <= maxLen) || (ranges.size() < 2)) {
+            return range;
+        }
+        int closest = 0;
+        for (int x = 1; x < ranges.size() - 1; x++) {
+            uint32_t gap = ranges[x + 1].first - (ranges[x].first + ranges[x].second);
+            uint32_t cgap = ranges[closest + 1].first - (ranges[closest].first + ranges[closest].second);
+            if (gap < cgap) {
+                closest = x;
+            }
+        }
+        ranges[closest].second = ranges[closest + 1].first + ranges[closest + 1].second - ranges[closest].first;
+        ranges.erase(ranges.begin() + closest + 1);
+    }
+}
+
 /*
  *
  */
@@ -438,18 +584,7 @@ void MultiSync::Ping(int discover)
 	}
     
     //update the range for local systems so it's accurate
-    const std::vector<std::pair<uint32_t, uint32_t>> &ranges = GetOutputRanges();
-    bool first = true;
-    std::string range;
-    for (auto &a : ranges) {
-        if (!first) {
-            range += ",";
-        }
-        char buf[64];
-        sprintf(buf, "%d-%d", a.first, (a.first + a.second - 1));
-        range += buf;
-        first = false;
-    }
+    std::string range = GetRangesString(MULTISYNC_PING_RANGES_LEN);
     for (int x = 0; x < m_numLocalSystems; x++) {
         pthread_mutex_lock(&m_systemsLock);
         MultiSyncSystem sysInfo = m_systems[x];
@@ -486,7 +621,7 @@ void MultiSync::Ping(int discover)
         strncpy((char *)(ed + 12), sysInfo.hostname.c_str(), 65);
         strncpy((char *)(ed + 77), sysInfo.version.c_str(), 41);
         strncpy((char *)(ed + 118), sysInfo.model.c_str(), 41);
-        strncpy((char *)(ed + 159), sysInfo.ranges.c_str(), 41);
+        strncpy((char *)(ed + 159), sysInfo.ranges.c_str(), MULTISYNC_PING_RANGES_LEN);
         SendBroadcastPacket(outBuf, sizeof(ControlPkt) + cpkt->extraDataLen);
     }
 }
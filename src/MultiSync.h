@@ -31,6 +31,11 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
 #include <jsoncpp/json/json.h>
 
 #include "settings.h"
@@ -143,6 +148,9 @@ class MultiSync {
 
 	Json::Value GetSystems(bool localOnly = false, bool timestamps = true);
 
+	int  GenerateRemoteSparseSequences(const std::string &sequence);
+	void QueueRemoteSparseSequences(const std::string &sequence);
+
 	void Ping(int discover = 0);
 	void Discover(void) { Ping(1); }
 
@@ -163,6 +171,7 @@ class MultiSync {
 	void FillLocalSystemInfo(void);
 	std::string GetHardwareModel(void);
     std::string GetTypeString(MultiSyncSystemType type);
+    std::string GetRangesString(size_t maxLen = std::string::npos);
 
 	int  OpenBroadcastSocket(void);
 	void SendBroadcastPacket(void *outBuf, int len);
@@ -230,6 +239,13 @@ class MultiSync {
     unsigned char rcvBuffers[MAX_MS_RCV_MSG][MAX_MS_RCV_BUFSIZE+1];
     unsigned char rcvCmbuf[MAX_MS_RCV_MSG][0x100];
     struct sockaddr_storage rcvSrcAddr[MAX_MS_RCV_MSG];
+
+	// sequences waiting for GenerateRemoteSparseSequences
+	void RemoteSparseSequencesLoop(void);
+	std::mutex             m_sparseLock;
+	std::list<std::string> m_sparseQueue;
+	std::thread           *m_sparseThread;
+	bool                   m_sparseRunning;
 };
 
 extern MultiSync *multiSync;
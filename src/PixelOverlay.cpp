@@ -43,6 +43,7 @@
 #include "PixelOverlayControl.h"
 #include "Sequence.h"
 #include "settings.h"
+#include "channeloutput.h"
 #include "channeloutputthread.h"
 
 char         *chanDataMap;
@@ -247,7 +248,9 @@ void OverlayMemoryMap(char *chanData) {
 			sizeof(FPPChannelMemoryMapControlHeader));
 
 	if (ctrlHeader->testMode) {
-		memcpy(chanData, chanDataMap, FPPD_MAX_CHANNELS);
+		for (auto &r : GetOutputRanges()) {
+			memcpy(chanData + r.first, chanDataMap + r.first, r.second);
+		}
 	} else {
 		for (i = 0; i < ctrlHeader->totalBlocks; i++, cb++) {
 			if (cb->isActive == 1) { // Active - Opaque
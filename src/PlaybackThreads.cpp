@@ -0,0 +1,218 @@
+/*
+ *   Playback thread scheduling for the Falcon Player Daemon
+ *   Falcon Player project (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      Initial development by:
+ *      - David Pitts (dpitts)
+ *      - Tony Mace (MyKroFt)
+ *      - Mathew Mrosko (Materdaddy)
+ *      - Chris Pinkham (CaptainMurdoch)
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <string>
+
+#include "log.h"
+#include "PlaybackThreads.h"
+#include "settings.h"
+
+static int       schedPolicy = SCHED_OTHER;
+static int       priorities[3] = { 0, 0, 0 };
+static cpu_set_t cpuMask;
+static bool      useCpuMask = false;
+static bool      lockMemory = false;
+
+// Parse a CPU list such as "2,3" or "1-3"
+static bool ParseCPUList(const char *str, cpu_set_t &mask) {
+    CPU_ZERO(&mask);
+
+    int cpus = 0;
+    const char *p = str;
+    while (*p) {
+        char *end;
+        int first = strtol(p, &end, 10);
+        if (end == p) {
+            return false;
+        }
+        int last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return false;
+            }
+            p = end;
+        }
+        for (int cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); cpu++) {
+            CPU_SET(cpu, &mask);
+            cpus++;
+        }
+        while ((*p == ',') || (*p == ' ')) {
+            p++;
+        }
+    }
+
+    return cpus > 0;
+}
+
+static int PrioritySetting(const char *setting, int defaultPriority) {
+    int priority = getSettingInt(setting);
+    if (priority <= 0) {
+        return defaultPriority;
+    }
+
+    int maxPriority = sched_get_priority_max(schedPolicy);
+    if (priority > maxPriority) {
+        priority = maxPriority;
+    }
+    return priority;
+}
+
+void InitPlaybackThreads(void) {
+    std::string policy = getSetting("PlaybackThreadScheduling");
+    if (policy == "FIFO") {
+        schedPolicy = SCHED_FIFO;
+    } else if (policy == "RR") {
+        schedPolicy = SCHED_RR;
+    } else {
+        schedPolicy = SCHED_OTHER;
+    }
+
+    if (schedPolicy != SCHED_OTHER) {
+        priorities[PLAYBACK_THREAD_OUTPUT] = PrioritySetting("OutputThreadPriority", PLAYBACK_OUTPUT_PRIORITY);
+        priorities[PLAYBACK_THREAD_READ] = PrioritySetting("ReadThreadPriority", PLAYBACK_READ_PRIORITY);
+        priorities[PLAYBACK_THREAD_MEDIA] = PrioritySetting("MediaThreadPriority", PLAYBACK_MEDIA_PRIORITY);
+
+        LogInfo(VB_GENERAL, "Playback threads using %s scheduling, priorities output %d, read %d, media %d\n",
+                policy.c_str(), priorities[PLAYBACK_THREAD_OUTPUT],
+                priorities[PLAYBACK_THREAD_READ], priorities[PLAYBACK_THREAD_MEDIA]);
+    }
+
+    const char *cpus = getSetting("PlaybackThreadCPUs");
+    useCpuMask = false;
+    if (cpus && *cpus) {
+        if (ParseCPUList(cpus, cpuMask)) {
+            useCpuMask = true;
+            LogInfo(VB_GENERAL, "Playback threads using CPUs %s\n", cpus);
+        } else {
+            LogWarn(VB_GENERAL, "Invalid PlaybackThreadCPUs setting '%s'\n", cpus);
+        }
+    }
+}
+
+/*
+ * Lock fppd's memory so the frame loop doesn't stall on page faults.  Only
+ * what is mapped now is locked, the code and buffers used while blanking
+ * the outputs are already resident.  Later mappings such as mapped sequence
+ * files aren't locked, playback buffers and thread stacks are locked as
+ * they are set up.
+ */
+void LockPlaybackMemory(void) {
+    if (!getSettingInt("LockPlaybackMemory")) {
+        return;
+    }
+
+#ifdef MCL_ONFAULT
+    // don't fault in the whole stack of every thread already running
+    if (mlockall(MCL_CURRENT | MCL_ONFAULT) == 0) {
+        lockMemory = true;
+        LogInfo(VB_GENERAL, "Locked memory\n");
+        return;
+    }
+#endif
+    if (mlockall(MCL_CURRENT) != 0) {
+        LogWarn(VB_GENERAL, "Could not lock memory: %s\n", strerror(errno));
+        return;
+    }
+    lockMemory = true;
+    LogInfo(VB_GENERAL, "Locked memory\n");
+}
+
+void LockPlaybackBuffer(const void *data, size_t size) {
+    if (!lockMemory || !data || !size) {
+        return;
+    }
+
+    if (mlock(data, size) != 0) {
+        LogWarn(VB_GENERAL, "Could not lock %d byte playback buffer: %s\n",
+                (int)size, strerror(errno));
+    }
+}
+
+// lock the top of the calling thread's stack, that is all the playback
+// loops use
+static void LockThreadStack(const char *threadName) {
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr)) {
+        return;
+    }
+
+    void  *stackAddr = nullptr;
+    size_t stackSize = 0;
+    if (!pthread_attr_getstack(&attr, &stackAddr, &stackSize) && stackAddr) {
+        size_t size = std::min(stackSize, (size_t)PLAYBACK_LOCKED_STACK_SIZE);
+        if (mlock((char*)stackAddr + stackSize - size, size) != 0) {
+            LogWarn(VB_GENERAL, "Could not lock stack of %s thread: %s\n",
+                    threadName, strerror(errno));
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+void SetupPlaybackThread(const char *name, PlaybackThreadType type) {
+    // thread names are limited to 15 characters
+    char threadName[16];
+    strncpy(threadName, name, sizeof(threadName) - 1);
+    threadName[sizeof(threadName) - 1] = 0;
+    pthread_setname_np(pthread_self(), threadName);
+
+    if (useCpuMask) {
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuMask), &cpuMask);
+        if (result) {
+            LogWarn(VB_GENERAL, "Could not set CPU affinity for %s thread: %s\n",
+                    threadName, strerror(result));
+        }
+    }
+
+    if (lockMemory) {
+        LockThreadStack(threadName);
+    }
+
+    if (schedPolicy != SCHED_OTHER) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priorities[type];
+
+        int result = pthread_setschedparam(pthread_self(), schedPolicy, &param);
+        if (result) {
+            LogWarn(VB_GENERAL, "Could not set priority %d for %s thread: %s\n",
+                    priorities[type], threadName, strerror(result));
+        } else {
+            LogDebug(VB_GENERAL, "%s thread priority set to %d\n",
+                     threadName, priorities[type]);
+        }
+    }
+}
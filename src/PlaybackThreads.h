@@ -0,0 +1,57 @@
+/*
+ *   Playback thread scheduling for the Falcon Player Daemon
+ *   Falcon Player project (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      Initial development by:
+ *      - David Pitts (dpitts)
+ *      - Tony Mace (MyKroFt)
+ *      - Mathew Mrosko (Materdaddy)
+ *      - Chris Pinkham (CaptainMurdoch)
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PLAYBACKTHREADS_H
+#define _PLAYBACKTHREADS_H
+
+#include <stddef.h>
+
+// Threads involved in playback can be given real time priorities and
+// pinned to a set of CPUs through settings so the frame loop isn't held
+// up by the web UI and other background work.
+enum PlaybackThreadType {
+    PLAYBACK_THREAD_OUTPUT, // output loop, pipeline, prep workers and outputs
+    PLAYBACK_THREAD_READ,   // sequence and sequence layer readers
+    PLAYBACK_THREAD_MEDIA   // audio/video decoding
+};
+
+// default SCHED_FIFO/SCHED_RR priorities when the setting is 0
+#define PLAYBACK_OUTPUT_PRIORITY 50
+#define PLAYBACK_READ_PRIORITY   40
+#define PLAYBACK_MEDIA_PRIORITY  30
+
+// how much of each playback thread's stack is locked with LockPlaybackMemory
+#define PLAYBACK_LOCKED_STACK_SIZE (128 * 1024)
+
+void InitPlaybackThreads(void);
+void LockPlaybackMemory(void);
+// Lock a buffer used during playback if LockPlaybackMemory is enabled
+void LockPlaybackBuffer(const void *data, size_t size);
+
+// Name the calling thread and apply the scheduling settings for its type
+void SetupPlaybackThread(const char *name, PlaybackThreadType type);
+
+#endif /* _PLAYBACKTHREADS_H */
@@ -26,20 +26,33 @@
 // This #define must be before any #include's
 #define _FILE_OFFSET_BITS 64
 
+#include <ctype.h>
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <math.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <boost/algorithm/string/predicate.hpp>
 
 #include "E131.h"
 #include "channeloutputthread.h"
 #include "common.h"
+#include "e131bridge.h"
 #include "events.h"
 #include "effects.h"
 #include "fpp.h" // for FPPstatus && #define-d status values
@@ -47,7 +60,9 @@
 #include "log.h"
 #include "MultiSync.h"
 #include "PixelOverlay.h"
+#include "PlaybackThreads.h"
 #include "Sequence.h"
+#include "SequenceLayer.h"
 #include "settings.h"
 #include <chrono>
 using namespace std::literals;
@@ -58,6 +73,35 @@ using namespace std::literals::chrono_literals;
 
 Sequence *sequence = NULL;
 
+class SequenceFrameData : public FSEQFile::BufferFrameData {
+  public:
+    SequenceFrameData() : BufferFrameData(nullptr), m_size(0) {}
+    virtual ~SequenceFrameData() {
+        free(m_data);
+    }
+
+    void reserve(uint32_t size) {
+        if (size > m_size) {
+            free(m_data);
+            m_data = nullptr;
+            m_size = 0;
+            if (posix_memalign((void**)&m_data, __BIGGEST_ALIGNMENT__, size) == 0) {
+                m_size = size;
+                LockPlaybackBuffer(m_data, m_size);
+            } else {
+                LogErr(VB_SEQUENCE, "Could not allocate %d byte frame buffer\n", size);
+            }
+        }
+    }
+    void release() {
+        free(m_data);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    uint32_t m_size;
+};
+
 Sequence::Sequence()
   :
     m_seqDuration(0),
@@ -65,6 +109,7 @@ Sequence::Sequence()
     m_seqSecondsRemaining(0),
     m_seqMSRemaining(0),
     m_seqFile(nullptr),
+    m_seqFileGeneration(0),
     m_seqStarting(0),
     m_seqPaused(0),
     m_seqSingleStep(0),
@@ -77,36 +122,212 @@ Sequence::Sequence()
     m_lastFrameRead(-1),
     m_doneRead(false),
     m_shuttingDown(false),
-    m_dataProcessed(false)
+    m_dataProcessed(false),
+    m_ringHead(0),
+    m_ringTail(0),
+    m_ringHistory(0),
+    m_readerWaiting(false),
+    m_consumerWaiting(false),
+    m_ringSize(SEQUENCE_FRAME_RING_MIN),
+    m_readAheadMS(SEQUENCE_READ_AHEAD_MS),
+    m_readAheadMaxFrames(SEQUENCE_FRAME_RING_MIN - SEQUENCE_HISTORY_FRAMECOUNT - 1),
+    m_readAheadFrames(SEQUENCE_READ_AHEAD_MIN_FRAMES),
+    m_readTimeAvg(0),
+    m_readTimePeak(0),
+    m_underruns(0),
+    m_prepareThread(nullptr),
+    m_cancelPrepare(false),
+    m_preparedSize(0),
+    m_preparedFile(nullptr),
+    m_transcodeThread(nullptr),
+    m_stopTranscoding(false),
+    m_interpSteps(1),
+    m_interpGamma(0.0f),
+    m_interpReadFrame(-1),
+    m_interpPrevFrame(-1),
+    m_interpNextFrame(-1),
+    m_interpReady(false),
+    m_interpPrepPending(false)
 {
     m_seqFilename[0] = 0;
     memset(m_seqData, 0, sizeof(m_seqData));
+
+    for (int x = 0; x < SEQUENCE_FRAME_RING_MAX; x++) {
+        m_frameRing[x] = new SequenceFrameData();
+    }
+    m_readerEventFD = eventfd(0, EFD_NONBLOCK);
+    m_consumerEventFD = eventfd(0, EFD_NONBLOCK);
 }
 
 Sequence::~Sequence()
 {
+    ReleasePreparedSequence();
+    if (m_transcodeThread) {
+        std::unique_lock<std::mutex> lock(m_transcodeLock);
+        m_stopTranscoding = true;
+        m_transcodeSignal.notify_all();
+        lock.unlock();
+        m_transcodeThread->join();
+        delete m_transcodeThread;
+    }
     m_shuttingDown = true;
-    frameLoadSignal.notify_all();
+    wakeReader();
     if (m_readThread) {
         m_readThread->join();
         delete m_readThread;
     }
-    clearCaches();
     if (m_seqFile) {
         delete m_seqFile;
     }
+    for (int x = 0; x < SEQUENCE_FRAME_RING_MAX; x++) {
+        delete m_frameRing[x];
+    }
+    close(m_readerEventFD);
+    close(m_consumerEventFD);
+}
+
+static void SignalEventFD(int fd) {
+    uint64_t v = 1;
+    if (write(fd, &v, sizeof(v)) != sizeof(v)) {
+        LogWarn(VB_SEQUENCE, "Could not signal sequence event: %s\n", strerror(errno));
+    }
+}
+
+//wait up to ms for the eventfd to be signaled, returns false on timeout
+static bool WaitEventFD(int fd, int ms) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int rc = poll(&pfd, 1, ms);
+    uint64_t v;
+    while (read(fd, &v, sizeof(v)) > 0) {
+    }
+    return rc > 0;
+}
+
+void Sequence::wakeReader() {
+    m_readerWaiting = false;
+    SignalEventFD(m_readerEventFD);
+}
+
+//caller must hold m_sequenceLock so the consumer side isn't running
+void Sequence::resetFrameRing(int nextFrame) {
+    std::unique_lock<std::mutex> readlock(readFileLock);
+    uint32_t head = m_ringHead;
+    m_ringTail = head;
+    m_ringHistory = head;
+    m_lastFrameRead = nextFrame - 1;
+    if (m_seqFile) {
+        m_doneRead = false;
+    }
+    readlock.unlock();
+    wakeReader();
+}
+
+//Size the ring for a newly opened sequence.  The ring gets room for twice
+//the target read-ahead so the depth can grow if reads turn out to be slow,
+//but never more frames than fit in SequenceReadAheadMaxMB.  Caller must
+//hold readFileLock with the read thread parked (m_seqStarting set)
+void Sequence::sizeFrameRing(FSEQFile *file) {
+    uint32_t blockSize = file->getDataBlockSize();
+    m_readAheadMS = getSettingInt("SequenceReadAheadMS");
+    if (m_readAheadMS <= 0) {
+        m_readAheadMS = SEQUENCE_READ_AHEAD_MS;
+    }
+    uint64_t maxMB = getSettingInt("SequenceReadAheadMaxMB");
+    if (maxMB <= 0) {
+        maxMB = SEQUENCE_READ_AHEAD_MAX_MB;
+    }
+    uint64_t maxFrames = maxMB * 1024 * 1024 / (blockSize ? blockSize : 1);
+    int target = m_readAheadMS / m_seqStepTime;
+
+    uint32_t ringSize = SEQUENCE_FRAME_RING_MIN;
+    while (ringSize < SEQUENCE_FRAME_RING_MAX
+           && ringSize < (target * 2 + SEQUENCE_HISTORY_FRAMECOUNT + 1)
+           && (ringSize * 2) <= maxFrames) {
+        ringSize *= 2;
+    }
+    for (uint32_t x = ringSize; x < SEQUENCE_FRAME_RING_MAX; x++) {
+        m_frameRing[x]->release();
+    }
+    m_ringSize = ringSize;
+    m_readAheadMaxFrames = ringSize - SEQUENCE_HISTORY_FRAMECOUNT - 1;
+    m_readTimeAvg = 0;
+    m_readTimePeak = 0;
+    m_underruns = 0;
+    updateReadAhead(0);
+
+    //preallocate what we expect to use, the rest is allocated if the
+    //read-ahead grows
+    uint32_t head = m_ringHead;
+    for (int x = 0; x < (m_readAheadFrames + SEQUENCE_HISTORY_FRAMECOUNT + 1); x++) {
+        ringFrame(head + x)->reserve(blockSize);
+    }
+    LogDebug(VB_SEQUENCE, "Read-ahead: %d frames (%d max), ring size %d\n",
+             (int)m_readAheadFrames, m_readAheadMaxFrames, m_ringSize);
 }
-void Sequence::clearCaches() {
-    while (!frameCache.empty()) {
-        delete frameCache.front();
-        frameCache.pop_front();
+
+//Called from the read thread after each frame is read.  Keeps enough frames
+//ready to cover the target time, to ride out a couple of the slowest reads
+//seen recently and a few more for each underrun of this sequence.
+void Sequence::updateReadAhead(int readTime) {
+    int avg = m_readTimeAvg;
+    avg += (readTime - avg) / 16;
+    m_readTimeAvg = avg;
+    int peak = m_readTimePeak;
+    if (readTime > peak) {
+        peak = readTime;
+    } else {
+        peak -= peak / 256;
     }
-    while (!pastFrameCache.empty()) {
-        delete pastFrameCache.front();
-        pastFrameCache.pop_front();
+    m_readTimePeak = peak;
+
+    int stepTime = m_seqStepTime * 1000;
+    int frames = m_readAheadMS * 1000 / stepTime;
+    int stallFrames = (peak * 2 + stepTime - 1) / stepTime;
+    if (stallFrames > frames) {
+        frames = stallFrames;
+    }
+    frames += m_underruns * SEQUENCE_READ_AHEAD_MIN_FRAMES;
+    if (frames > m_readAheadMaxFrames) {
+        frames = m_readAheadMaxFrames;
     }
+    if (frames < SEQUENCE_READ_AHEAD_MIN_FRAMES) {
+        frames = SEQUENCE_READ_AHEAD_MIN_FRAMES;
+    }
+    m_readAheadFrames = frames;
+}
+
+void Sequence::GetReadAheadStatus(Json::Value &result) {
+    int frames = m_readAheadFrames;
+    result["frames"] = frames;
+    result["max_frames"] = m_readAheadMaxFrames;
+    result["ms"] = frames * m_seqStepTime;
+    result["ready"] = (uint32_t)(m_ringHead - m_ringTail);
+    result["underruns"] = (int)m_underruns;
+    result["read_time_avg_us"] = (int)m_readTimeAvg;
+    result["read_time_peak_us"] = (int)m_readTimePeak;
 }
 
+//Called on the consumer side when the ring is empty.  Returns true
+//if a frame became available (or reading finished) within ms
+bool Sequence::waitForFrame(int ms) {
+    auto endTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (true) {
+        m_consumerWaiting = true;
+        if (m_doneRead || m_ringHead != m_ringTail) {
+            m_consumerWaiting = false;
+            return true;
+        }
+        int left = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - std::chrono::steady_clock::now()).count();
+        if (left <= 0) {
+            m_consumerWaiting = false;
+            return false;
+        }
+        WaitEventFD(m_consumerEventFD, left);
+    }
+}
 
 /*
  *
@@ -116,50 +337,474 @@ void ReadSequenceDataThread(Sequence *sequence) {
     sequence->ReadFramesLoop();
 }
 void Sequence::ReadFramesLoop() {
-    std::unique_lock<std::mutex> lock(frameCacheLock);
-    while (true) {
-        if (m_shuttingDown) {
+    SetupPlaybackThread("fppd_seqread", PLAYBACK_THREAD_READ);
+
+    std::unique_lock<std::mutex> readlock(readFileLock);
+    while (!m_shuttingDown) {
+        //flag that we may wait before checking the ring so the consumer
+        //can't drain it between the check and the wait without waking us
+        m_readerWaiting = true;
+        FSEQFile *file = m_seqFile;
+        uint32_t generation = m_seqFileGeneration;
+        uint32_t head = m_ringHead;
+        uint32_t ready = head - m_ringTail;
+        if (m_seqStarting >= 2 || file == nullptr || m_doneRead
+            || ready >= m_readAheadFrames
+            || (head - m_ringHistory) >= m_ringSize) {
+            //nothing to do, sleep until the consumer drains the ring down
+            //to half the read-ahead or the ring is restarted
+            readlock.unlock();
+            WaitEventFD(m_readerEventFD, 25);
+            readlock.lock();
+            continue;
+        }
+        m_readerWaiting = false;
+
+        uint64_t frame = m_lastFrameRead + 1;
+        if (frame >= file->getNumFrames()) {
+            m_doneRead = true;
+            SignalEventFD(m_consumerEventFD);
+            continue;
+        }
+
+        SequenceFrameData *fd = ringFrame(head);
+        fd->reserve(file->getDataBlockSize());
+        if (fd->m_size < file->getDataBlockSize()) {
+            readlock.unlock();
+            WaitEventFD(m_readerEventFD, 25);
+            readlock.lock();
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (!file->fillFrame(frame, fd)) {
+            memset(fd->m_data, 0, file->getDataBlockSize());
+        }
+        updateReadAhead(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        if (generation != m_seqFileGeneration) {
+            //the file was replaced while reading, drop the frame
+            continue;
+        }
+        int expected = frame - 1;
+        if (!m_lastFrameRead.compare_exchange_strong(expected, (int)frame)) {
+            //this frame was late, the consumer has already moved past it
+            continue;
+        }
+        m_ringHead = head + 1;
+        if (m_consumerWaiting.exchange(false)) {
+            SignalEventFD(m_consumerEventFD);
+        }
+    }
+}
+
+//Full path of a sequence in the sequence directory, checking for a host
+//specific version on remotes
+std::string Sequence::GetSequencePath(const char *filename) {
+    char tmpFilename[2048];
+    strcpy(tmpFilename,(const char *)getSequenceDirectory());
+    strcat(tmpFilename,"/");
+    strcat(tmpFilename, filename);
+
+    if (getFPPmode() == REMOTE_MODE)
+        CheckForHostSpecificFile(getSetting("HostName"), tmpFilename);
+
+    std::string transcoded = GetTranscodedPath(tmpFilename);
+    if (!transcoded.empty() && IsTranscodeCurrent(tmpFilename, transcoded)) {
+        LogDebug(VB_SEQUENCE, "Using %s for %s\n", transcoded.c_str(), tmpFilename);
+        return transcoded;
+    }
+    return tmpFilename;
+}
+
+//The optimized copy of a sequence is named after the sequence plus a hash
+//of the codec and output ranges, so changing either makes a new copy
+std::string Sequence::GetTranscodedPath(const std::string &path) {
+    std::string codec = getSetting("SequenceTranscode");
+    if (codec.empty()) {
+        codec = SEQUENCE_TRANSCODE_CODEC;
+    }
+    if (codec == "off") {
+        return "";
+    }
+    std::string key = codec;
+    for (auto &r : GetOutputRanges()) {
+        key += ":" + std::to_string(r.first) + "+" + std::to_string(r.second);
+    }
+    char hash[16];
+    sprintf(hash, "%08x", (uint32_t)std::hash<std::string>()(key));
+
+    std::string name = path.substr(path.rfind('/') + 1);
+    if (boost::iends_with(name, ".fseq")) {
+        name = name.substr(0, name.length() - 5);
+    }
+    return std::string(getMediaDirectory()) + "/cache/" + name + "@" + hash + ".fseq";
+}
+
+//Whether a file in the cache is a transcoded copy, or its .source or .tmp
+//file, for the sequence with the given "<name>@" prefix.  The hash has to
+//follow the prefix directly so "Show@" doesn't match copies of "Show@2019".
+static bool IsTranscodedName(const std::string &name, const std::string &prefix) {
+    if (!boost::starts_with(name, prefix) || (name.length() < (prefix.length() + 8))) {
+        return false;
+    }
+    for (int x = 0; x < 8; x++) {
+        if (!isxdigit(name[prefix.length() + x])) {
+            return false;
+        }
+    }
+    std::string ext = name.substr(prefix.length() + 8);
+    return (ext == ".fseq") || (ext == ".fseq.source") || (ext == ".fseq.tmp");
+}
+
+//Size and modification time of a sequence, kept in a .source file next to
+//its transcoded copy to tell if the copy was made from the current file
+static std::string TranscodeSourceStamp(const std::string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st)) {
+        return "";
+    }
+    return std::to_string((uint64_t)st.st_size) + ":" + std::to_string((uint64_t)st.st_mtim.tv_sec)
+        + "." + std::to_string((uint64_t)st.st_mtim.tv_nsec);
+}
+
+bool Sequence::IsTranscodeCurrent(const std::string &path, const std::string &transcoded) {
+    std::string stamp = TranscodeSourceStamp(path);
+    if (stamp.empty() || !FileExists(transcoded)) {
+        return false;
+    }
+    char buf[64];
+    FILE *f = fopen((transcoded + ".source").c_str(), "r");
+    if (f == nullptr) {
+        return false;
+    }
+    bool current = fgets(buf, sizeof(buf), f) && stamp == buf;
+    fclose(f);
+    return current;
+}
+
+//Queue file for transcoding if it's slower to read than it needs to be
+void Sequence::QueueTranscode(const std::string &path, FSEQFile *file) {
+    std::string transcoded = GetTranscodedPath(path);
+    if (transcoded.empty() || boost::starts_with(path, std::string(getMediaDirectory()) + "/cache/")) {
+        return;
+    }
+    bool slow = file->getVersionMajor() == 1;
+    if (!slow) {
+        V2FSEQFile *v2 = (V2FSEQFile*)file;
+        if (!v2->m_sparseRanges.empty()) {
             return;
         }
-        int cacheSize = frameCache.size();
-        if (frameCache.size() < SEQUENCE_CACHE_FRAMECOUNT && m_seqStarting < 2 && m_seqFile && !m_doneRead) {
-            uint64_t frame = m_lastFrameRead + 1;
-            if (frame < m_seqFile->getNumFrames()) {
-                lock.unlock();
-                
-                std::unique_lock<std::mutex> readlock(readFileLock);
-                FSEQFile *file = m_seqFile;
-                FSEQFile::FrameData *fd = nullptr;
-                if (m_doneRead || file == nullptr) {
-                    //memset(fd->data, 0, maxChanToRead);
-                } else {
-                    fd = m_seqFile->getFrame(frame);
-                }
-                readlock.unlock();
-                
-                lock.lock();
-                if (fd) {
-                    if (m_lastFrameRead == (frame - 1)) {
-                        m_lastFrameRead = frame;
-                        frameCache.push_back(fd);
-
-                        lock.unlock();
-                        frameLoadedSignal.notify_all();
-                        std::this_thread::sleep_for(5ms);
-                        lock.lock();
-                    } else {
-                        //a skip is in progress, we don't need this frame anymore
-                        delete fd;
+        slow = v2->m_compressionType == FSEQFile::CompressionType::zlib;
+    }
+    //reading only the output ranges of a mostly unused file is slow too
+    uint64_t needed = 0;
+    for (auto &r : GetOutputRanges()) {
+        needed += r.second;
+    }
+    if (!slow && needed * 2 >= file->getChannelCount()) {
+        return;
+    }
+    if (IsTranscodeCurrent(path, transcoded)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_transcodeLock);
+    if (std::find(m_transcodeQueue.begin(), m_transcodeQueue.end(), path) != m_transcodeQueue.end()) {
+        return;
+    }
+    LogDebug(VB_SEQUENCE, "Queueing %s to be transcoded\n", path.c_str());
+    m_transcodeQueue.push_back(path);
+    if (m_transcodeThread == nullptr) {
+        m_transcodeThread = new std::thread(&Sequence::TranscodeLoop, this);
+    }
+    m_transcodeSignal.notify_all();
+}
+
+void Sequence::TranscodeLoop() {
+    //only use otherwise idle CPU and disk time so playback isn't affected,
+    //on Linux these just change the priorities of this thread
+    setpriority(PRIO_PROCESS, 0, 19);
+#ifdef SYS_ioprio_set
+    static const int IOPRIO_WHO_PROCESS = 1;
+    static const int IOPRIO_CLASS_IDLE = 3;
+    static const int IOPRIO_CLASS_SHIFT = 13;
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT)) {
+        LogDebug(VB_SEQUENCE, "Could not set idle IO priority for transcoding: %s\n", strerror(errno));
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(m_transcodeLock);
+    while (!m_stopTranscoding) {
+        if (m_transcodeQueue.empty()) {
+            m_transcodeSignal.wait(lock);
+            continue;
+        }
+        std::string path = m_transcodeQueue.front();
+        lock.unlock();
+
+        std::string transcoded = GetTranscodedPath(path);
+        if (!transcoded.empty() && !IsTranscodeCurrent(path, transcoded)) {
+            std::string cacheDir = std::string(getMediaDirectory()) + "/cache";
+            mkdir(cacheDir.c_str(), 0755);
+
+            std::string codec = getSetting("SequenceTranscode");
+            FSEQFile::CompressionType ct = FSEQFile::CompressionType::zstd;
+            if (codec == "lz4") {
+                ct = FSEQFile::CompressionType::lz4;
+            } else if (codec == "none") {
+                ct = FSEQFile::CompressionType::none;
+            }
+
+            //stamp the copy with the source as it was before reading it so
+            //a change while transcoding makes it out of date
+            std::string stamp = TranscodeSourceStamp(path);
+            std::string stampFile = transcoded + ".source";
+            unlink(stampFile.c_str());
+
+            LogInfo(VB_SEQUENCE, "Transcoding %s to %s\n", path.c_str(), transcoded.c_str());
+            auto start = std::chrono::steady_clock::now();
+            if (WriteSparseSequence(path, transcoded, GetOutputRanges(), ct, &m_stopTranscoding)) {
+                LogInfo(VB_SEQUENCE, "Transcoded %s in %dms\n", path.c_str(),
+                        (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+
+                //remove copies made for other codecs/output ranges
+                std::string prefix = transcoded.substr(cacheDir.length() + 1);
+                prefix = prefix.substr(0, prefix.rfind('@') + 1);
+                DIR *dir = opendir(cacheDir.c_str());
+                if (dir) {
+                    struct dirent *ent;
+                    while ((ent = readdir(dir)) != nullptr) {
+                        std::string name = ent->d_name;
+                        if (IsTranscodedName(name, prefix) && (cacheDir + "/" + name) != transcoded) {
+                            unlink((cacheDir + "/" + name).c_str());
+                        }
                     }
+                    closedir(dir);
+                }
+
+                FILE *f = fopen(stampFile.c_str(), "w");
+                if (f) {
+                    fputs(stamp.c_str(), f);
+                    fclose(f);
+                } else {
+                    LogWarn(VB_SEQUENCE, "Could not write %s: %s\n", stampFile.c_str(), strerror(errno));
                 }
-            } else {
-                frameLoadedSignal.notify_all();
-                m_doneRead = true;
             }
-        } else {
-            frameLoadSignal.wait_for(lock, 25ms);
         }
+
+        lock.lock();
+        m_transcodeQueue.pop_front();
+    }
+}
+
+//Clip sorted ranges to the channels in src, the same as the ranges of the
+//sparse copy WriteSparseSequence makes.  Frames are read at their absolute
+//channels, which for a sparse source go past its channel count, so the
+//number of channels a frame buffer needs is returned.
+uint32_t Sequence::ClipSparseRanges(const FSEQFile *src,
+                                    std::vector<std::pair<uint32_t, uint32_t>> &ranges) {
+    uint32_t channelCount = std::max(src->getMaxChannel() + 1, src->getChannelCount());
+    while (!ranges.empty() && (ranges.back().first >= channelCount)) {
+        ranges.pop_back();
+    }
+    if (!ranges.empty() && (ranges.back().second > (channelCount - ranges.back().first))) {
+        ranges.back().second = channelCount - ranges.back().first;
+    }
+    return channelCount;
+}
+
+//Sparse copy of the given channel ranges of a sequence, ranges past the end
+//of the sequence are dropped.  It's written to a temporary name and renamed
+//so a partial file is never used.
+bool Sequence::WriteSparseSequence(const std::string &srcName, const std::string &destName,
+                                   std::vector<std::pair<uint32_t, uint32_t>> ranges,
+                                   FSEQFile::CompressionType ct,
+                                   const std::atomic_bool *cancel) {
+    std::unique_ptr<FSEQFile> src(FSEQFile::openFSEQFile(srcName));
+    if (!src) {
+        LogErr(VB_SEQUENCE, "Could not open %s to create %s\n", srcName.c_str(), destName.c_str());
+        return false;
+    }
+
+    uint32_t channelCount = ClipSparseRanges(src.get(), ranges);
+    if (ranges.empty()) {
+        LogWarn(VB_SEQUENCE, "No channels in %s for %s\n", srcName.c_str(), destName.c_str());
+        return false;
+    }
+
+    std::string tmpName = destName + ".tmp";
+    V2FSEQFile *dest = (V2FSEQFile*)FSEQFile::createFSEQFile(tmpName, 2, ct, -1);
+    if (!dest) {
+        LogErr(VB_SEQUENCE, "Could not create %s\n", tmpName.c_str());
+        return false;
+    }
+    dest->m_sparseRanges = ranges;
+    //only this player reads the transcoded copy, use short blocks
+    dest->m_extendedBlockIndex = true;
+    src->prepareRead(ranges);
+    dest->initializeFromFSEQ(*src);
+    //the ranges are clipped to the channel count when the header is written
+    dest->setChannelCount(channelCount);
+    dest->writeHeader();
+
+    std::vector<uint8_t> data(channelCount);
+    for (uint32_t x = 0; x < src->getNumFrames(); x++) {
+        if (cancel && *cancel) {
+            delete dest;
+            unlink(tmpName.c_str());
+            return false;
+        }
+        FSEQFile::FrameData *fdata = src->getFrame(x);
+        if (fdata) {
+            fdata->readFrame(&data[0]);
+            delete fdata;
+        }
+        dest->addFrame(x, &data[0]);
+    }
+    dest->finalize();
+    delete dest;
+
+    if (rename(tmpName.c_str(), destName.c_str())) {
+        LogErr(VB_SEQUENCE, "Could not rename %s to %s: %s\n",
+            tmpName.c_str(), destName.c_str(), strerror(errno));
+        unlink(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+//Start opening the sequence and reading its first frames in the background.
+//If the next OpenSequenceFile is for the same sequence from the start, it
+//will use the prepared file and frames instead of waiting on the file.
+void Sequence::PrepareSequenceFile(const char *filename) {
+    int warmStartMS = getSettingInt("SequenceWarmStartMS");
+    if (warmStartMS < 0 || !filename || !filename[0]) {
+        return;
+    }
+    std::string path = GetSequencePath(filename);
+    std::unique_lock<std::mutex> lock(m_preparedLock);
+    if (m_prepareThread && path == m_preparedPath) {
+        return;
+    }
+    lock.unlock();
+    ReleasePreparedSequence();
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return;
+    }
+    LogDebug(VB_SEQUENCE, "Preparing sequence %s\n", filename);
+    lock.lock();
+    m_preparedPath = path;
+    m_preparedSize = st.st_size;
+    m_preparedMTime = st.st_mtim;
+    m_cancelPrepare = false;
+    m_prepareThread = new std::thread(&Sequence::PrepareSequenceLoop, this, path);
+}
+
+void Sequence::PrepareSequenceLoop(std::string path) {
+    FSEQFile *seqFile = FSEQFile::openFSEQFile(path);
+    if (seqFile == nullptr) {
+        LogWarn(VB_SEQUENCE, "Could not prepare sequence file %s\n", path.c_str());
+        return;
+    }
+    if (getSettingInt("mmapSequenceFiles")) {
+        seqFile->mapFile();
+    }
+    seqFile->prepareRead(GetOutputRanges());
+
+    int warmStartMS = getSettingInt("SequenceWarmStartMS");
+    if (warmStartMS <= 0) {
+        warmStartMS = SEQUENCE_WARM_START_MS;
+    }
+    uint32_t count = warmStartMS / seqFile->getStepTime();
+    if (count > seqFile->getNumFrames()) {
+        count = seqFile->getNumFrames();
+    }
+    //OpenSequenceFile only keeps what fits in the ring's read-ahead
+    uint64_t maxMB = getSettingInt("SequenceReadAheadMaxMB");
+    if (maxMB <= 0) {
+        maxMB = SEQUENCE_READ_AHEAD_MAX_MB;
+    }
+    uint64_t maxFrames = maxMB * 1024 * 1024 / 2 / (seqFile->getDataBlockSize() ? seqFile->getDataBlockSize() : 1);
+    if (count > maxFrames) {
+        count = maxFrames;
+    }
+    if (count > SEQUENCE_FRAME_RING_MAX / 2) {
+        count = SEQUENCE_FRAME_RING_MAX / 2;
+    }
+    std::vector<SequenceFrameData*> frames;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t x = 0; x < count && !m_cancelPrepare; x++) {
+        SequenceFrameData *fd = new SequenceFrameData();
+        fd->reserve(seqFile->getDataBlockSize());
+        if (fd->m_size < seqFile->getDataBlockSize()) {
+            delete fd;
+            break;
+        }
+        if (!seqFile->fillFrame(x, fd)) {
+            memset(fd->m_data, 0, seqFile->getDataBlockSize());
+        }
+        frames.push_back(fd);
+    }
+    LogDebug(VB_SEQUENCE, "Prepared %d frames of %s in %dms\n", (int)frames.size(), path.c_str(),
+             (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+
+    std::unique_lock<std::mutex> lock(m_preparedLock);
+    m_preparedFile = seqFile;
+    m_preparedFrames.swap(frames);
+}
+
+//Returns the prepared file if it's for path, frames gets the frames
+//already read from it.  Anything prepared for another file is discarded.
+FSEQFile *Sequence::TakePreparedSequence(const std::string &path, std::vector<SequenceFrameData*> &frames) {
+    std::unique_lock<std::mutex> lock(m_preparedLock);
+    if (m_prepareThread == nullptr) {
+        return nullptr;
+    }
+    //the file may have been replaced since it was prepared
+    struct stat st;
+    if (path != m_preparedPath || stat(path.c_str(), &st) != 0
+        || st.st_size != m_preparedSize
+        || st.st_mtim.tv_sec != m_preparedMTime.tv_sec
+        || st.st_mtim.tv_nsec != m_preparedMTime.tv_nsec) {
+        lock.unlock();
+        ReleasePreparedSequence();
+        return nullptr;
+    }
+    std::thread *t = m_prepareThread;
+    lock.unlock();
+    //if it's not done yet, it's still ahead of opening the file again
+    t->join();
+    lock.lock();
+    delete m_prepareThread;
+    m_prepareThread = nullptr;
+    m_preparedPath.clear();
+    FSEQFile *seqFile = m_preparedFile;
+    m_preparedFile = nullptr;
+    frames.swap(m_preparedFrames);
+    return seqFile;
+}
+
+void Sequence::ReleasePreparedSequence(void) {
+    std::unique_lock<std::mutex> lock(m_preparedLock);
+    std::thread *t = m_prepareThread;
+    m_prepareThread = nullptr;
+    m_preparedPath.clear();
+    m_cancelPrepare = true;
+    lock.unlock();
+    if (t) {
+        t->join();
+        delete t;
+    }
+    lock.lock();
+    if (m_preparedFile) {
+        delete m_preparedFile;
+        m_preparedFile = nullptr;
     }
+    for (auto fd : m_preparedFrames) {
+        delete fd;
+    }
+    m_preparedFrames.clear();
 }
 
 int Sequence::OpenSequenceFile(const char *filename, int startFrame, int startSecond) {
@@ -179,14 +824,7 @@ int Sequence::OpenSequenceFile(const char *filename, int startFrame, int startSe
 
     m_seqStarting = 2;
     m_doneRead = false;
-    m_lastFrameRead = -1;
-    if (startFrame) {
-        m_lastFrameRead = startFrame - 1;
-    }
-
-    std::unique_lock<std::mutex> lock(frameCacheLock);
-    clearCaches();
-    lock.unlock();
+    resetFrameRing(startFrame);
     
     m_seqPaused   = 0;
     m_seqDuration = 0;
@@ -199,33 +837,42 @@ int Sequence::OpenSequenceFile(const char *filename, int startFrame, int startSe
 
     strcpy(m_seqFilename, filename);
 
-    char tmpFilename[2048];
-    unsigned char tmpData[2048];
-    strcpy(tmpFilename,(const char *)getSequenceDirectory());
-    strcat(tmpFilename,"/");
-    strcat(tmpFilename, filename);
-
-    if (getFPPmode() == REMOTE_MODE)
-        CheckForHostSpecificFile(getSetting("HostName"), tmpFilename);
+    std::string tmpFilename = GetSequencePath(filename);
 
-    if (!FileExists(tmpFilename)) {
+    if (!FileExists(tmpFilename.c_str())) {
         if (getFPPmode() == REMOTE_MODE)
-            LogDebug(VB_SEQUENCE, "Sequence file %s does not exist\n", tmpFilename);
+            LogDebug(VB_SEQUENCE, "Sequence file %s does not exist\n", tmpFilename.c_str());
         else
-            LogErr(VB_SEQUENCE, "Sequence file %s does not exist\n", tmpFilename);
+            LogErr(VB_SEQUENCE, "Sequence file %s does not exist\n", tmpFilename.c_str());
 
         m_seqStarting = 0;
         return 0;
     }
     
+    std::unique_lock<std::mutex> readLock(readFileLock);
     m_seqFile = nullptr;
-    FSEQFile *seqFile = FSEQFile::openFSEQFile(tmpFilename);
+    m_seqFileGeneration++;
+    readLock.unlock();
+
+    FSEQFile::setBlockCacheSize((uint64_t)getSettingInt("FSEQCacheMB") * 1024 * 1024);
+
+    //use the warm started file if it was prepared for this
+    std::vector<SequenceFrameData*> preparedFrames;
+    FSEQFile *seqFile = nullptr;
+    if (startFrame == 0 && startSecond <= 0) {
+        seqFile = TakePreparedSequence(tmpFilename, preparedFrames);
+    }
+    bool prepared = seqFile != nullptr;
+    if (!prepared) {
+        seqFile = FSEQFile::openFSEQFile(tmpFilename);
+    }
     if (seqFile == NULL) {
         LogErr(VB_SEQUENCE, "Error opening sequence file: %s. FSEQFile::openFSEQFile returned NULL\n",
-            tmpFilename);
+            tmpFilename.c_str());
         m_seqStarting = 0;
         return 0;
     }
+    QueueTranscode(tmpFilename, seqFile);
 
     if (getFPPmode() == MASTER_MODE) {
         seqLock.unlock();
@@ -246,19 +893,47 @@ int Sequence::OpenSequenceFile(const char *filename, int startFrame, int startSe
         if (m_lastFrameRead < -1) m_lastFrameRead = -1;
     }
 
-    seqFile->prepareRead(GetOutputRanges());
+    if (!prepared) {
+        if (getSettingInt("mmapSequenceFiles")) {
+            //uncompressed sequences can be read straight out of the page cache
+            seqFile->mapFile();
+        }
+        seqFile->prepareRead(GetOutputRanges());
+    }
     // Calculate duration
     m_seqMSRemaining = seqFile->getNumFrames() * seqFile->getStepTime();
     m_seqDuration = m_seqMSRemaining;
     m_seqDuration /= 1000;
     m_seqSecondsRemaining = m_seqDuration;
     SetChannelOutputRefreshRate(m_seqRefreshRate);
-    
+    SetupInterpolation();
     
     //start reading frames
+    readLock.lock();
+    sizeFrameRing(seqFile);
+    if (!preparedFrames.empty()) {
+        //move the frames that were already read into the ring, the old
+        //ring frames are freed along with preparedFrames
+        uint32_t head = m_ringHead;
+        int count = preparedFrames.size();
+        if (count > m_readAheadMaxFrames) {
+            count = m_readAheadMaxFrames;
+        }
+        for (int x = 0; x < count; x++) {
+            std::swap(m_frameRing[(head + x) & (m_ringSize - 1)], preparedFrames[x]);
+        }
+        m_ringHead = head + count;
+        m_lastFrameRead = count - 1;
+        LogDebug(VB_SEQUENCE, "Warm start of %s with %d frames ready\n", filename, count);
+    }
     m_seqFile = seqFile;
+    m_seqFileGeneration++;
+    readLock.unlock();
+    for (auto fd : preparedFrames) {
+        delete fd;
+    }
     m_seqStarting = 1;  //beyond header, read loop can start reading frames
-    frameLoadSignal.notify_all();
+    wakeReader();
     m_seqStarting = 0;
     m_seqPaused = 0;
     m_seqSingleStep = 0;
@@ -283,29 +958,28 @@ int Sequence::SeekSequenceFile(int frameNumber) {
         LogErr(VB_SEQUENCE, "No sequence is running\n");
         return 0;
     }
-    seqLock.unlock();
-    
-    std::unique_lock<std::mutex> lock(frameCacheLock);
-    while (!pastFrameCache.empty()
-        && frameNumber >= pastFrameCache.back()->frame) {
-        //Going backwords but frame is cached, we'll push the old frames
-        frameCache.push_front(pastFrameCache.back());
-        pastFrameCache.pop_back();
-    }
-    while (!frameCache.empty() && frameCache.front()->frame < frameNumber) {
-        delete frameCache.front();
-        frameCache.pop_front();
+
+    uint32_t head = m_ringHead;
+    uint32_t tail = m_ringTail;
+    uint32_t history = m_ringHistory;
+    while (tail != history && ringFrame(tail - 1)->frame >= frameNumber) {
+        //Going backwords but frame is still in the history
+        tail--;
     }
-    if (!frameCache.empty() && frameNumber < frameCache.front()->frame) {
-        clearCaches();
+    while (tail != head && ringFrame(tail)->frame < frameNumber) {
+        tail++;
     }
     LogDebug(VB_SEQUENCE, "Seeking to %d.   Last read is %d\n", frameNumber, (int)m_lastFrameRead);
-    if (frameCache.empty()) {
-        m_lastFrameRead = frameNumber - 1;
-        frameLoadSignal.notify_all();
+    if (tail == head || ringFrame(tail)->frame != frameNumber) {
+        resetFrameRing(frameNumber);
+    } else {
+        if ((tail - history) > SEQUENCE_HISTORY_FRAMECOUNT) {
+            m_ringHistory = tail - SEQUENCE_HISTORY_FRAMECOUNT;
+        }
+        m_ringTail = tail;
+        wakeReader();
     }
-    lock.unlock();
-    frameLoadSignal.notify_all();
+    return 1;
 }
 
 
@@ -331,7 +1005,10 @@ int Sequence::IsSequenceRunning(char *filename) {
 }
 
 void Sequence::BlankSequenceData(void) {
-    memset(m_seqData, 0, sizeof(m_seqData));
+    //only the channels that are output need to be cleared
+    for (auto &r : GetOutputRanges()) {
+        memset(m_seqData + r.first, 0, r.second);
+    }
 }
 
 int Sequence::SequenceIsPaused(void) {
@@ -365,21 +1042,18 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
             m_seqSingleStep = 0;
         } else if (m_seqSingleStepBack) {
             m_seqSingleStepBack = 0;
-            std::unique_lock<std::mutex> lock(frameCacheLock);
-            if (!pastFrameCache.empty()) {
-                frameCache.push_front(pastFrameCache.back());
-                pastFrameCache.pop_back();
-            } else if (frameCache.empty()) {
-                m_lastFrameRead = -1;
-                frameLoadSignal.notify_all();
+            uint32_t tail = m_ringTail;
+            if ((tail - m_ringHistory) >= 2) {
+                //back up over the current frame to the one before it
+                m_ringTail = tail - 2;
             } else {
-                int f = frameCache.front()->frame - 1;
-                m_lastFrameRead = f - 1;
-                if (m_lastFrameRead < -1) {
-                    m_lastFrameRead = -1;
+                int f = 0;
+                if (tail != m_ringHistory) {
+                    f = ringFrame(tail - 1)->frame - 1;
+                } else if (tail != m_ringHead) {
+                    f = ringFrame(tail)->frame - 2;
                 }
-                clearCaches();
-                frameLoadSignal.notify_all();
+                resetFrameRing(f < 0 ? 0 : f);
             }
         } else {
             return;
@@ -389,45 +1063,55 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
     if (forceFirstFrame || IsSequenceRunning()) {
         m_remoteBlankCount = 0;
 
-        std::unique_lock<std::mutex> lock(frameCacheLock);
-        if (frameCache.empty() && !m_doneRead) {
+        uint32_t tail = m_ringTail;
+        if (m_ringHead == tail && !m_doneRead) {
             //wait up to the step time, if we don't have the frame, bail
-            frameLoadedSignal.wait_for(lock, std::chrono::milliseconds(m_seqStepTime - 1));
+            waitForFrame(m_seqStepTime - 1);
         }
-        if (!frameCache.empty()) {
-            FSEQFile::FrameData *data = frameCache.front();
-            frameCache.pop_front();
-            if (pastFrameCache.size() > 5) {
-                delete pastFrameCache.front();
-                pastFrameCache.pop_front();
+        //check m_doneRead first, it's set after the last frame is added
+        bool doneRead = m_doneRead;
+        uint32_t head = m_ringHead;
+        if (head != tail) {
+            SequenceFrameData *data = ringFrame(tail);
+            tail++;
+            m_ringTail = tail;
+            if ((tail - m_ringHistory) > SEQUENCE_HISTORY_FRAMECOUNT) {
+                m_ringHistory = tail - SEQUENCE_HISTORY_FRAMECOUNT;
+            }
+            if ((head - tail) <= (m_readAheadFrames / 2) && m_readerWaiting.exchange(false)) {
+                SignalEventFD(m_readerEventFD);
             }
-            pastFrameCache.push_back(data);
-            lock.unlock();
-            frameLoadSignal.notify_all();
             
             data->readFrame((uint8_t*)m_seqData);
+            m_interpReadFrame = data->frame;
             SetChannelOutputFrameNumber(data->frame);
             m_seqSecondsElapsed = data->frame * m_seqStepTime;
             m_seqSecondsElapsed /= 1000;
             m_seqSecondsRemaining = m_seqDuration - m_seqSecondsElapsed;
             m_dataProcessed = false;
-        } else if (m_doneRead) {
-            lock.unlock();
+        } else if (doneRead) {
             m_seqSecondsElapsed = m_seqDuration;
             m_seqSecondsRemaining = m_seqDuration - m_seqSecondsElapsed;
             CloseSequenceFile();
         } else {
             if (m_lastFrameRead > 0) {
-                //we'll have the read thread discard the frame
+                //skip the late frame so the read thread doesn't waste
+                //time on it, and read further ahead from now on
+                if (++m_underruns == 1) {
+                    LogWarn(VB_SEQUENCE, "Frame %d of %s was not read in time, increasing read-ahead\n",
+                            (int)m_lastFrameRead + 1, m_seqFilename);
+                } else {
+                    LogDebug(VB_SEQUENCE, "Frame %d not read in time, %d underruns\n",
+                             (int)m_lastFrameRead + 1, (int)m_underruns);
+                }
                 m_lastFrameRead++;
-                if (!pastFrameCache.empty()) {
+                if (tail != m_ringHistory) {
                     //and copy the last frame data
-                    pastFrameCache.back()->readFrame((uint8_t*)m_seqData);
+                    ringFrame(tail - 1)->readFrame((uint8_t*)m_seqData);
                     m_dataProcessed = false;
                 }
             }
-            lock.unlock();
-            frameLoadSignal.notify_all();
+            wakeReader();
         }
     } else {
         if (getFPPmode() != REMOTE_MODE || getSettingInt("blankBetweenSequences")) {
@@ -447,6 +1131,9 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
 }
 
 void Sequence::ProcessSequenceData(int ms, int checkControlChannels) {
+    if (IsSequenceLayerRunning())
+        OverlaySequenceLayers(m_seqData);
+
     if (IsEffectRunning())
         OverlayEffects(m_seqData);
 
@@ -474,15 +1161,149 @@ void Sequence::ProcessSequenceData(int ms, int checkControlChannels) {
 
     if (channelTester->Testing())
         channelTester->OverlayTestData(m_seqData);
-    
-    PrepareChannelData(m_seqData);
+
+    if (m_interpSteps > 1)
+        SaveInterpolationFrame();
+
+    //record bridged data before the outputs process it so recordings are
+    //the same with or without the output pipeline
+    if (getFPPmode() == BRIDGE_MODE)
+        Bridge_RecordFrame(m_seqData);
+
+    //the output pipeline prepares its own copy of the data.  If interpolated
+    //frames go out first the outputs are prepared with those, so this frame
+    //is only prepared once it is sent.
+    m_interpPrepPending = false;
+    if (!UsingOutputPipeline()) {
+        if ((m_interpSteps > 1) && m_interpReady)
+            m_interpPrepPending = true;
+        else
+            PrepareChannelData(m_seqData);
+    }
     m_dataProcessed = true;
 }
 
 void Sequence::SendSequenceData(void) {
+    if (UsingOutputPipeline()) {
+        QueueChannelData(m_seqData);
+        return;
+    }
+    if (m_interpPrepPending) {
+        m_interpPrepPending = false;
+        PrepareChannelData(m_seqData);
+    }
     SendChannelData(m_seqData);
 }
 
+//Read the interpolation settings for the sequence being opened
+void Sequence::SetupInterpolation(void) {
+    int steps = getSettingInt("SequenceInterpolation");
+    if (steps > SEQUENCE_INTERPOLATION_MAX) {
+        steps = SEQUENCE_INTERPOLATION_MAX;
+    }
+    while (steps > 1 && (m_seqStepTime / steps) < SEQUENCE_INTERPOLATION_MIN_MS) {
+        steps--;
+    }
+    m_interpReady = false;
+    m_interpReadFrame = -1;
+    m_interpPrevFrame = -1;
+    m_interpNextFrame = -1;
+    if (steps <= 1) {
+        m_interpSteps = 1;
+        return;
+    }
+
+    if (m_interpData.empty()) {
+        m_interpPrev.resize(FPPD_MAX_CHANNELS);
+        m_interpNext.resize(FPPD_MAX_CHANNELS);
+        m_interpData.resize(FPPD_MAX_CHANNELS);
+    }
+
+    //blending in linear light looks closer to a sequence rendered at the
+    //higher rate when the lights apply a gamma curve
+    float gamma = atof(getSetting("SequenceInterpolationGamma"));
+    if (gamma > 0.0f && gamma != 1.0f) {
+        if (gamma != m_interpGamma) {
+            m_interpFromLinear.resize(65536);
+            for (int x = 0; x < 256; x++) {
+                m_interpToLinear[x] = (uint16_t)(powf(x / 255.0f, gamma) * 65535.0f + 0.5f);
+            }
+            for (int x = 0; x < 65536; x++) {
+                m_interpFromLinear[x] = (uint8_t)(powf(x / 65535.0f, 1.0f / gamma) * 255.0f + 0.5f);
+            }
+        }
+        m_interpGamma = gamma;
+    } else {
+        m_interpGamma = 0.0f;
+    }
+    LogDebug(VB_SEQUENCE, "Interpolating %d frames per sequence frame, gamma %.2f\n", steps, m_interpGamma);
+    m_interpSteps = steps;
+}
+
+//Keep the unprocessed copy of a newly read frame, the previous one becomes
+//the frame interpolated from
+void Sequence::SaveInterpolationFrame(void) {
+    if (m_interpReadFrame < 0) {
+        //blanking or processing the same frame again, nothing to blend
+        m_interpReady = false;
+        return;
+    }
+    std::swap(m_interpPrev, m_interpNext);
+    m_interpPrevFrame = m_interpNextFrame;
+    m_interpNextFrame = m_interpReadFrame;
+    m_interpReadFrame = -1;
+    for (auto &r : GetOutputRanges()) {
+        memcpy(&m_interpNext[r.first], m_seqData + r.first, r.second);
+    }
+    m_interpReady = (m_interpPrevFrame >= 0) && (m_interpNextFrame == m_interpPrevFrame + 1);
+}
+
+//weight is out of 256, kept simple so the compiler can vectorize it even
+//though fppd is normally built with -O1
+__attribute__ ((optimize ("tree-vectorize")))
+static void InterpolateRange(uint8_t *out, const uint8_t *prev, const uint8_t *next,
+                             uint32_t len, uint32_t weight) {
+    uint16_t w = weight;
+    uint16_t inv = 256 - weight;
+    for (uint32_t x = 0; x < len; x++) {
+        out[x] = (uint16_t)(prev[x] * inv + next[x] * w + 128) >> 8;
+    }
+}
+static void InterpolateRangeGamma(uint8_t *out, const uint8_t *prev, const uint8_t *next,
+                                  uint32_t len, uint32_t weight,
+                                  const uint16_t *toLinear, const uint8_t *fromLinear) {
+    uint32_t inv = 256 - weight;
+    for (uint32_t x = 0; x < len; x++) {
+        out[x] = fromLinear[(toLinear[prev[x]] * inv + toLinear[next[x]] * weight + 128) >> 8];
+    }
+}
+
+//Send the frame step/steps of the way from the previous sequence frame to
+//the current one.  Called by the output thread between sequence frames.
+void Sequence::SendInterpolatedData(int step) {
+    int steps = m_interpSteps;
+    if (!m_interpReady || m_seqPaused || step <= 0 || step >= steps) {
+        return;
+    }
+
+    uint32_t weight = step * 256 / steps;
+    for (auto &r : GetOutputRanges()) {
+        if (m_interpGamma > 0.0f) {
+            InterpolateRangeGamma(&m_interpData[r.first], &m_interpPrev[r.first], &m_interpNext[r.first],
+                                  r.second, weight, m_interpToLinear, &m_interpFromLinear[0]);
+        } else {
+            InterpolateRange(&m_interpData[r.first], &m_interpPrev[r.first], &m_interpNext[r.first],
+                             r.second, weight);
+        }
+    }
+    if (UsingOutputPipeline()) {
+        QueueChannelData((char*)&m_interpData[0], 0);
+        return;
+    }
+    PrepareChannelData((char*)&m_interpData[0]);
+    SendChannelData((char*)&m_interpData[0], 0);
+}
+
 void Sequence::SendBlankingData(void) {
     LogDebug(VB_SEQUENCE, "SendBlankingData()\n");
     std::this_thread::sleep_for(5ms);
@@ -511,20 +1332,25 @@ void Sequence::CloseSequenceFile(void) {
 
     std::unique_lock<std::mutex> readLock(readFileLock);
     if (m_seqFile) {
+        if (m_underruns) {
+            LogInfo(VB_SEQUENCE, "%s had %d underruns, read-ahead was %d frames, read time avg %dus, peak %dus\n",
+                    m_seqFilename, (int)m_underruns, (int)m_readAheadFrames,
+                    (int)m_readTimeAvg, (int)m_readTimePeak);
+        }
         delete m_seqFile;
         m_seqFile = nullptr;
+        m_seqFileGeneration++;
     }
-    readLock.unlock();
-    
-    std::unique_lock<std::mutex> lock(frameCacheLock);
-    clearCaches();
+    m_ringTail = (uint32_t)m_ringHead;
+    m_ringHistory = (uint32_t)m_ringHead;
     m_doneRead = true;
     m_lastFrameRead = -1;
-    lock.unlock();
-    frameLoadedSignal.notify_all();
+    readLock.unlock();
+    SignalEventFD(m_consumerEventFD);
     
     m_seqFilename[0] = '\0';
     m_seqPaused = 0;
+    m_interpReady = false;
 
     if ((!IsEffectRunning()) &&
         ((getFPPmode() != REMOTE_MODE) &&
@@ -33,9 +33,12 @@
 #include <mutex>
 #include <thread>
 #include <list>
+#include <vector>
 #include <atomic>
 #include <condition_variable>
 
+#include <jsoncpp/json/json.h>
+
 #include "fseq/FSEQFile.h"
 
 
@@ -43,7 +46,31 @@
 #define FPPD_MAX_CHANNELS 1048580
 #define DATA_DUMP_SIZE    28
 
-#define SEQUENCE_CACHE_FRAMECOUNT 20
+//The read-ahead depth is sized at runtime from the step time and the
+//measured read/decode time of recent frames.  The SequenceReadAheadMS and
+//SequenceReadAheadMaxMB settings override the defaults.
+#define SEQUENCE_READ_AHEAD_MS         1000
+#define SEQUENCE_READ_AHEAD_MAX_MB     64
+#define SEQUENCE_READ_AHEAD_MIN_FRAMES 4
+#define SEQUENCE_HISTORY_FRAMECOUNT 6
+//must be powers of 2, the ring used for a sequence is sized between these
+#define SEQUENCE_FRAME_RING_MIN 16
+#define SEQUENCE_FRAME_RING_MAX 1024
+//how much of the next playlist sequence is read before it starts, can be
+//changed with the SequenceWarmStartMS setting, -1 disables warm starts
+#define SEQUENCE_WARM_START_MS 1000
+
+//codec for optimized copies of slow to read sequences, changed with the
+//SequenceTranscode setting, "off" disables them
+#define SEQUENCE_TRANSCODE_CODEC "zstd"
+
+//the SequenceInterpolation setting has the output thread send this many
+//frames per sequence frame, the extra frames are blended between the
+//sequence frames.  Frames are never sent closer than the minimum.
+#define SEQUENCE_INTERPOLATION_MAX    4
+#define SEQUENCE_INTERPOLATION_MIN_MS 10
+
+class SequenceFrameData;
 
 class Sequence {
   public:
@@ -53,6 +80,8 @@ class Sequence {
 	int   IsSequenceRunning(void);
 	int   IsSequenceRunning(char *filename);
 	int   OpenSequenceFile(const char *filename, int startFrame = 0, int startSecond = -1);
+	void  PrepareSequenceFile(const char *filename);
+	void  ReleasePreparedSequence(void);
 	void  ProcessSequenceData(int ms, int checkControlChannels = 1);
 	int   SeekSequenceFile(int frameNumber);
 	void  ReadSequenceData(bool forceFirstFrame = false);
@@ -65,6 +94,16 @@ class Sequence {
 	void  SingleStepSequenceBack(void);
 	int   SequenceIsPaused(void);
     bool  isDataProcessed() const { return m_dataProcessed; }
+    int   GetInterpolationSteps(void) const { return m_interpSteps; }
+    void  SendInterpolatedData(int step);
+    void  GetReadAheadStatus(Json::Value &result);
+
+    static uint32_t ClipSparseRanges(const FSEQFile *src,
+                                     std::vector<std::pair<uint32_t, uint32_t>> &ranges);
+    static bool WriteSparseSequence(const std::string &srcName, const std::string &destName,
+                                    std::vector<std::pair<uint32_t, uint32_t>> ranges,
+                                    FSEQFile::CompressionType ct,
+                                    const std::atomic_bool *cancel = nullptr);
 
 	int           m_seqDuration;
 	int           m_seqSecondsElapsed;
@@ -77,10 +116,14 @@ class Sequence {
 	void  BlankSequenceData(void);
 	char  NormalizeControlValue(char in);
 	char *CurrentSequenceFilename(void);
+	std::string GetSequencePath(const char *filename);
 
 	FSEQFile     *m_seqFile;
+	// bumped each time m_seqFile changes so the read thread never mistakes
+	// a new file allocated at the same address for the one it read from
+	uint32_t      m_seqFileGeneration;
 
-    volatile int  m_seqStarting;
+    std::atomic_int m_seqStarting;
 	int           m_seqPaused;
     int           m_seqStepTime;
 	int           m_seqSingleStep;
@@ -94,19 +137,91 @@ class Sequence {
     std::recursive_mutex m_sequenceLock;
     
     std::atomic_int m_lastFrameRead;
-    volatile bool m_doneRead;
+    std::atomic_bool m_doneRead;
     volatile bool m_shuttingDown;
     std::thread *m_readThread;
-    std::list<FSEQFile::FrameData*> frameCache;
-    std::list<FSEQFile::FrameData*> pastFrameCache;
-    void clearCaches();
-    std::mutex frameCacheLock;
+
+    //Single producer (read thread) / single consumer (ReadSequenceData) ring
+    //of preallocated frames.  [m_ringHistory, m_ringTail) have already been
+    //played and are kept for stepping back, [m_ringTail, m_ringHead) are
+    //ready to be played.  Only the read thread advances m_ringHead and only
+    //the consumer moves m_ringTail/m_ringHistory.  Anything that restarts
+    //the ring holds both m_sequenceLock and readFileLock.
+    SequenceFrameData *m_frameRing[SEQUENCE_FRAME_RING_MAX];
+    uint32_t m_ringSize;
+    std::atomic<uint32_t> m_ringHead;
+    std::atomic<uint32_t> m_ringTail;
+    std::atomic<uint32_t> m_ringHistory;
+    std::atomic_bool m_readerWaiting;
+    std::atomic_bool m_consumerWaiting;
+    int m_readerEventFD;
+    int m_consumerEventFD;
+    SequenceFrameData *ringFrame(uint32_t idx) { return m_frameRing[idx & (m_ringSize - 1)]; }
+    void resetFrameRing(int nextFrame);
+    void sizeFrameRing(FSEQFile *file);
+    bool waitForFrame(int ms);
+    void wakeReader();
+
+    //adaptive read-ahead, the read thread keeps m_readAheadFrames ready
+    //and is woken again when the ring drains to half of that
+    int m_readAheadMS;
+    int m_readAheadMaxFrames;
+    std::atomic_int m_readAheadFrames;
+    std::atomic_int m_readTimeAvg;   //us per frame
+    std::atomic_int m_readTimePeak;  //us, slowest recent frame, usually a block decode
+    std::atomic_int m_underruns;
+    void updateReadAhead(int readTime);
+
     std::mutex readFileLock; //lock for just the stuff needed to read from the file (m_seqFile variable)
-    std::condition_variable frameLoadSignal;
-    std::condition_variable frameLoadedSignal;
+
+    //warm start, the next sequence in the playlist is opened and its first
+    //frames read in the background so OpenSequenceFile can start it without
+    //waiting on the file.  m_prepared* are protected by m_preparedLock
+    std::mutex m_preparedLock;
+    std::thread *m_prepareThread;
+    std::atomic_bool m_cancelPrepare;
+    std::string m_preparedPath;
+    off_t m_preparedSize;
+    struct timespec m_preparedMTime;
+    FSEQFile *m_preparedFile;
+    std::vector<SequenceFrameData*> m_preparedFrames;
+    FSEQFile *TakePreparedSequence(const std::string &path, std::vector<SequenceFrameData*> &frames);
+
+    //V1 and zlib sequences, and sequences where only a small part of the
+    //channels are output, are transcoded in the background into an
+    //optimized copy in the media cache directory which GetSequencePath
+    //uses once it's up to date.  The original file is left alone.
+    std::mutex m_transcodeLock;
+    std::condition_variable m_transcodeSignal;
+    std::thread *m_transcodeThread;
+    std::atomic_bool m_stopTranscoding;
+    std::list<std::string> m_transcodeQueue;
+    std::string GetTranscodedPath(const std::string &path);
+    bool IsTranscodeCurrent(const std::string &path, const std::string &transcoded);
+    void QueueTranscode(const std::string &path, FSEQFile *file);
+
+    //frame interpolation, the unprocessed data of the last two frames
+    //read is kept so the output thread can send frames between them.
+    //Only used from the output thread except for the setup on open.
+    std::atomic_int m_interpSteps;
+    float m_interpGamma;
+    int   m_interpReadFrame; //frame read into m_seqData and not saved yet
+    int   m_interpPrevFrame;
+    int   m_interpNextFrame;
+    bool  m_interpReady;
+    bool  m_interpPrepPending; //m_seqData is prepared when it is sent
+    std::vector<uint8_t> m_interpPrev;
+    std::vector<uint8_t> m_interpNext;
+    std::vector<uint8_t> m_interpData;
+    uint16_t m_interpToLinear[256];
+    std::vector<uint8_t> m_interpFromLinear;
+    void SetupInterpolation(void);
+    void SaveInterpolationFrame(void);
 
     public:
     void ReadFramesLoop();
+    void PrepareSequenceLoop(std::string path);
+    void TranscodeLoop();
 };
 
 extern Sequence *sequence;
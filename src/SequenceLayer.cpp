@@ -0,0 +1,484 @@
+/*
+ *   Sequence Layers for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      Initial development by:
+ *      - David Pitts (dpitts)
+ *      - Tony Mace (MyKroFt)
+ *      - Mathew Mrosko (Materdaddy)
+ *      - Chris Pinkham (CaptainMurdoch)
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include "channeloutput.h"
+#include "channeloutputthread.h"
+#include "common.h"
+#include "effects.h"
+#include "log.h"
+#include "PlaybackThreads.h"
+#include "Sequence.h"
+#include "SequenceLayer.h"
+#include "settings.h"
+#include "fseq/FSEQFile.h"
+
+class SequenceLayerFrame : public FSEQFile::BufferFrameData {
+  public:
+    SequenceLayerFrame(uint32_t size) : BufferFrameData(nullptr), m_buffer(size), m_layerFrame(0) {
+        m_data = &m_buffer[0];
+        LockPlaybackBuffer(m_data, size);
+    }
+
+    std::vector<uint8_t> m_buffer;
+    uint64_t             m_layerFrame; //counts up across loops
+};
+
+class SequenceLayer {
+  public:
+    SequenceLayer(const std::string &name, FSEQFile *file,
+                  const std::vector<std::pair<uint32_t, uint32_t>> &ranges, int loop);
+    ~SequenceLayer();
+
+    bool Overlay(char *channelData);
+    void Blank(char *channelData);
+    void GetStatus(Json::Value &result);
+    void ReadLoop();
+
+    std::string m_name;
+    int         m_loop;
+    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
+
+  private:
+    FSEQFile   *m_file;
+    uint32_t    m_numFrames;
+    int         m_stepTime;
+    long long   m_startTime;
+    int         m_underruns;
+
+    //where each layer range is in the packed frame data
+    struct RangeCopy {
+        uint32_t src;
+        uint32_t dest;
+        uint32_t len;
+    };
+    std::vector<RangeCopy> m_copies;
+
+    //m_free, m_ready, m_nextRead, m_stopping and m_currentFrame are
+    //protected by m_lock, m_current is only used by the output thread
+    std::mutex              m_lock;
+    std::condition_variable m_signal;
+    std::thread            *m_readThread;
+    bool                    m_stopping;
+    uint64_t                m_nextRead;
+    std::vector<SequenceLayerFrame*> m_frames;
+    std::list<SequenceLayerFrame*>   m_free;
+    std::list<SequenceLayerFrame*>   m_ready;
+    SequenceLayerFrame     *m_current;
+    uint64_t                m_currentFrame;
+};
+
+SequenceLayer::SequenceLayer(const std::string &name, FSEQFile *file,
+                             const std::vector<std::pair<uint32_t, uint32_t>> &ranges, int loop)
+  : m_name(name),
+    m_loop(loop),
+    m_ranges(ranges),
+    m_file(file),
+    m_numFrames(file->getNumFrames()),
+    m_stepTime(file->getStepTime() ? file->getStepTime() : 50),
+    m_startTime(0),
+    m_underruns(0),
+    m_readThread(nullptr),
+    m_stopping(false),
+    m_nextRead(0),
+    m_current(nullptr),
+    m_currentFrame(0)
+{
+    int count = std::max(SEQUENCE_LAYER_READ_AHEAD_MS / m_stepTime, 4) + 1;
+    for (int i = 0; i < count; i++) {
+        SequenceLayerFrame *f = new SequenceLayerFrame(m_file->getDataBlockSize());
+        m_frames.push_back(f);
+        m_free.push_back(f);
+    }
+    m_readThread = new std::thread(&SequenceLayer::ReadLoop, this);
+}
+
+SequenceLayer::~SequenceLayer()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_stopping = true;
+    lock.unlock();
+    m_signal.notify_all();
+
+    m_readThread->join();
+    delete m_readThread;
+
+    for (auto f : m_frames)
+        delete f;
+    delete m_file;
+
+    if (m_underruns)
+        LogInfo(VB_SEQUENCE, "Sequence layer %s had %d underruns\n", m_name.c_str(), m_underruns);
+}
+
+void SequenceLayer::ReadLoop()
+{
+    SetupPlaybackThread("fppd_layer", PLAYBACK_THREAD_READ);
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (!m_stopping) {
+        if (m_free.empty() || (!m_loop && (m_nextRead >= m_numFrames))) {
+            m_signal.wait(lock);
+            continue;
+        }
+        SequenceLayerFrame *f = m_free.front();
+        m_free.pop_front();
+        uint64_t frame = m_nextRead++;
+        lock.unlock();
+
+        if (!m_file->fillFrame(frame % m_numFrames, f))
+            memset(f->m_data, 0, f->m_buffer.size());
+        f->m_layerFrame = frame;
+
+        lock.lock();
+        if (m_copies.empty()) {
+            uint32_t pos = 0;
+            for (auto &fr : *f->m_ranges) {
+                for (auto &r : m_ranges) {
+                    uint32_t start = std::max(fr.first, r.first);
+                    uint32_t end = std::min(fr.first + fr.second, r.first + r.second);
+                    if (start < end)
+                        m_copies.push_back({pos + start - fr.first, start, end - start});
+                }
+                pos += fr.second;
+            }
+        }
+        m_ready.push_back(f);
+    }
+}
+
+/*
+ * Copy the current frame of the layer into the channel data, returns false
+ * once a layer that isn't looping is done
+ */
+bool SequenceLayer::Overlay(char *channelData)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    // start the clock once the first frame is ready
+    if (!m_startTime) {
+        if (m_ready.empty())
+            return true;
+        m_startTime = GetMonotonicTime();
+    }
+
+    uint64_t target = (GetMonotonicTime() - m_startTime) / (m_stepTime * 1000);
+    if (!m_loop && (target >= m_numFrames))
+        return false;
+
+    bool freed = false;
+    while (!m_ready.empty() && (m_ready.front()->m_layerFrame <= target)) {
+        if (m_current)
+            m_free.push_back(m_current);
+        m_current = m_ready.front();
+        m_ready.pop_front();
+        m_currentFrame = m_current->m_layerFrame;
+        freed = true;
+    }
+    if (m_ready.empty() && (m_current->m_layerFrame < target)) {
+        // the read thread fell behind, skip it ahead
+        if (m_nextRead < target)
+            m_nextRead = target;
+        m_underruns++;
+    }
+    lock.unlock();
+
+    if (freed)
+        m_signal.notify_one();
+
+    for (auto &c : m_copies)
+        memcpy(channelData + c.dest, m_current->m_data + c.src, c.len);
+
+    return true;
+}
+
+void SequenceLayer::Blank(char *channelData)
+{
+    for (auto &r : m_ranges)
+        memset(channelData + r.first, 0, r.second);
+}
+
+void SequenceLayer::GetStatus(Json::Value &result)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    result["name"] = m_name;
+    result["loop"] = m_loop;
+    result["stepTime"] = m_stepTime;
+    result["numFrames"] = m_numFrames;
+    result["frame"] = (Json::UInt)(m_currentFrame % m_numFrames);
+    result["framesReady"] = (int)m_ready.size();
+    result["underruns"] = m_underruns;
+
+    Json::Value ranges(Json::arrayValue);
+    for (auto &r : m_ranges)
+        ranges.append(std::to_string(r.first + 1) + "-" + std::to_string(r.first + r.second));
+    result["ranges"] = ranges;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static std::mutex                layersLock;
+static std::list<SequenceLayer*> layers;
+// channels of stopped layers which still need to be cleared
+static std::vector<std::pair<uint32_t, uint32_t>> layerBlankRanges;
+// layers which finished on their own, deleted by the cleanup thread so
+// the output thread doesn't wait for their read threads to exit
+static std::list<SequenceLayer*> finishedLayers;
+static std::condition_variable   finishedSignal;
+static std::thread              *cleanupThread = nullptr;
+static bool                      cleanupStopping = false;
+
+static void SequenceLayerCleanupLoop()
+{
+    std::unique_lock<std::mutex> lock(layersLock);
+    while (true) {
+        if (finishedLayers.empty()) {
+            if (cleanupStopping)
+                break;
+            finishedSignal.wait(lock);
+            continue;
+        }
+
+        std::list<SequenceLayer*> finished;
+        finished.swap(finishedLayers);
+        lock.unlock();
+
+        for (auto l : finished)
+            delete l;
+
+        lock.lock();
+    }
+}
+
+/*
+ * Start a sequence on the given channel ranges on top of whatever else
+ * is playing.  A layer already running the same sequence is replaced.
+ */
+int StartSequenceLayer(const std::string &sequenceName,
+                       const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+                       int loop)
+{
+    LogInfo(VB_SEQUENCE, "Starting sequence layer %s\n", sequenceName.c_str());
+
+    std::string filename = getSequenceDirectory();
+    filename += "/";
+    filename += sequenceName;
+    if (!boost::ends_with(filename, ".fseq"))
+        filename += ".fseq";
+
+    FSEQFile *file = FSEQFile::openFSEQFile(filename);
+    if (!file) {
+        LogErr(VB_SEQUENCE, "Unable to open sequence layer %s\n", filename.c_str());
+        return 0;
+    }
+    if (!file->getNumFrames()) {
+        LogErr(VB_SEQUENCE, "Sequence layer %s has no frames\n", filename.c_str());
+        delete file;
+        return 0;
+    }
+
+    // only read the channels in the layer that are actually output
+    uint32_t maxChannel = file->getMaxChannel();
+    std::vector<std::pair<uint32_t, uint32_t>> layerRanges = ranges;
+    if (layerRanges.empty())
+        layerRanges.push_back(std::pair<uint32_t, uint32_t>(0, maxChannel));
+
+    std::vector<std::pair<uint32_t, uint32_t>> readRanges;
+    for (auto &r : layerRanges) {
+        for (auto &o : GetOutputRanges()) {
+            uint32_t start = std::max(r.first, o.first);
+            uint32_t end = std::min(std::min(r.first + r.second, o.first + o.second), maxChannel);
+            if (start < end)
+                readRanges.push_back(std::pair<uint32_t, uint32_t>(start, end - start));
+        }
+    }
+    MergeChannelRanges(readRanges);
+    if (readRanges.empty()) {
+        LogErr(VB_SEQUENCE, "Sequence layer %s has no channels which are output\n", sequenceName.c_str());
+        delete file;
+        return 0;
+    }
+    file->prepareRead(readRanges);
+    int frameTime = file->getStepTime() ? file->getStepTime() : 50;
+
+    SequenceLayer *old = nullptr;
+    std::unique_lock<std::mutex> lock(layersLock);
+    for (auto it = layers.begin(); it != layers.end(); ++it) {
+        if ((*it)->m_name == sequenceName) {
+            old = *it;
+            layers.erase(it);
+            layerBlankRanges.insert(layerBlankRanges.end(), old->m_ranges.begin(), old->m_ranges.end());
+            break;
+        }
+    }
+    if (layers.size() >= SEQUENCE_LAYER_MAX) {
+        lock.unlock();
+        LogErr(VB_SEQUENCE, "Unable to start sequence layer %s, maximum number of layers already running\n",
+            sequenceName.c_str());
+        delete old;
+        delete file;
+        return 0;
+    }
+    if (!cleanupThread)
+        cleanupThread = new std::thread(SequenceLayerCleanupLoop);
+    layers.push_back(new SequenceLayer(sequenceName, file, readRanges, loop));
+    int layerCount = layers.size();
+    lock.unlock();
+
+    delete old;
+
+    StartChannelOutputThread();
+
+    if (!sequence->IsSequenceRunning() && !IsEffectRunning() && (layerCount == 1)) {
+        //first layer running, nothing else running, set the refresh rate
+        //to the rate of the layer
+        SetChannelOutputRefreshRate(1000 / frameTime);
+    }
+
+    return 1;
+}
+
+int StopSequenceLayer(const std::string &sequenceName)
+{
+    LogDebug(VB_SEQUENCE, "StopSequenceLayer(%s)\n", sequenceName.c_str());
+
+    SequenceLayer *layer = nullptr;
+    std::unique_lock<std::mutex> lock(layersLock);
+    for (auto it = layers.begin(); it != layers.end(); ++it) {
+        if ((*it)->m_name == sequenceName) {
+            layer = *it;
+            layers.erase(it);
+            layerBlankRanges.insert(layerBlankRanges.end(), layer->m_ranges.begin(), layer->m_ranges.end());
+            break;
+        }
+    }
+    lock.unlock();
+
+    if (!layer)
+        return 0;
+
+    delete layer;
+    return 1;
+}
+
+void StopAllSequenceLayers(void)
+{
+    LogDebug(VB_SEQUENCE, "Stopping all sequence layers\n");
+
+    std::unique_lock<std::mutex> lock(layersLock);
+    std::list<SequenceLayer*> stopped;
+    stopped.swap(layers);
+    for (auto l : stopped)
+        layerBlankRanges.insert(layerBlankRanges.end(), l->m_ranges.begin(), l->m_ranges.end());
+
+    cleanupStopping = true;
+    std::thread *t = cleanupThread;
+    lock.unlock();
+    finishedSignal.notify_all();
+
+    for (auto l : stopped)
+        delete l;
+
+    if (t) {
+        t->join();
+        delete t;
+    }
+
+    lock.lock();
+    cleanupThread = nullptr;
+    cleanupStopping = false;
+}
+
+/*
+ * Layers that were just stopped count as running until their channels have
+ * been cleared so the output thread sends the blank data
+ */
+int IsSequenceLayerRunning(void)
+{
+    std::unique_lock<std::mutex> lock(layersLock);
+    return layers.size() + (layerBlankRanges.empty() ? 0 : 1);
+}
+
+/*
+ * Overlay the current frame of each layer onto raw channel data, called
+ * from the channel output thread
+ */
+int OverlaySequenceLayers(char *channelData)
+{
+    std::unique_lock<std::mutex> lock(layersLock);
+
+    for (auto &r : layerBlankRanges)
+        memset(channelData + r.first, 0, r.second);
+    layerBlankRanges.clear();
+
+    bool finished = false;
+    for (auto it = layers.begin(); it != layers.end(); ) {
+        SequenceLayer *layer = *it;
+        if (layer->Overlay(channelData)) {
+            ++it;
+            continue;
+        }
+
+        LogDebug(VB_SEQUENCE, "Sequence layer %s finished\n", layer->m_name.c_str());
+        layer->Blank(channelData);
+        it = layers.erase(it);
+        finishedLayers.push_back(layer);
+        finished = true;
+    }
+    int count = layers.size();
+    lock.unlock();
+
+    if (finished)
+        finishedSignal.notify_one();
+
+    return count;
+}
+
+Json::Value GetSequenceLayers(void)
+{
+    Json::Value result;
+    Json::Value list(Json::arrayValue);
+
+    std::unique_lock<std::mutex> lock(layersLock);
+    for (auto layer : layers) {
+        Json::Value l;
+        layer->GetStatus(l);
+        list.append(l);
+    }
+    result["layers"] = list;
+
+    return result;
+}
@@ -0,0 +1,52 @@
+/*
+ *   Sequence Layers for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      Initial development by:
+ *      - David Pitts (dpitts)
+ *      - Tony Mace (MyKroFt)
+ *      - Mathew Mrosko (Materdaddy)
+ *      - Chris Pinkham (CaptainMurdoch)
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SEQUENCELAYER_H
+#define _SEQUENCELAYER_H
+
+#include <string>
+#include <vector>
+
+#include <jsoncpp/json/json.h>
+
+// Sequence layers are extra sequences played at the same time as the main
+// sequence, each restricted to its own channel ranges.  Every layer has its
+// own read thread and is copied over the main sequence data each frame,
+// layers started later are on top of earlier ones.
+#define SEQUENCE_LAYER_MAX           16
+#define SEQUENCE_LAYER_READ_AHEAD_MS 500
+
+// ranges are 0 based start channel and channel count, empty for the whole
+// sequence
+int  StartSequenceLayer(const std::string &sequenceName,
+                        const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+                        int loop = 0);
+int  StopSequenceLayer(const std::string &sequenceName);
+void StopAllSequenceLayers(void);
+int  IsSequenceLayerRunning(void);
+int  OverlaySequenceLayers(char *channelData);
+Json::Value GetSequenceLayers(void);
+
+#endif /* _SEQUENCELAYER_H */
@@ -33,6 +33,9 @@
 
 #define ARTNET_HEADER_LENGTH         18
 
+// well inside the 4 second refresh Art-Net nodes expect
+#define ARTNET_KEEP_ALIVE_MS         2000
+
 class ArtNetOutputData : public UDPOutputData {
 public:
     ArtNetOutputData(const Json::Value &config);
@@ -44,6 +47,8 @@ public:
     virtual void CreateBroadcastMessages(std::vector<struct mmsghdr> &bMsgs);
     virtual void AddPostDataMessages(std::vector<struct mmsghdr> &bMsgs);
     virtual void DumpConfig();
+
+    virtual int  MaxKeepAliveMS() { return ARTNET_KEEP_ALIVE_MS; }
     
     int           universe;
     int           priority;
@@ -26,12 +26,14 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 
 #include "BBBMatrix.h"
 #include "BBBUtils.h"
 #include "common.h"
 #include "log.h"
+#include "OutputWorkers.h"
 
 
 // These are the number of clock cycles it takes to clock out a single "row" of bits (1 bit) for 32x16 1/8 P10 scan panels.  Other
@@ -708,65 +710,79 @@ void BBBMatrix::PrepData(unsigned char *channelData)
     rowLen /= 8;
     
     memset(m_outputFrame, 0, m_outputs * m_longestChain * m_panelHeight * m_panelWidth * 3);
-    for (int output = 0; output < m_outputs; output++) {
-        int panelsOnOutput = m_panelMatrix->m_outputPanels[output].size();
+
+    // Each scanned row is a separate block of the output frame, the outputs
+    // share bytes within a row so the rows are packed in parallel instead.
+    int rows = 0;
+    for (int y = 0; y < (m_panelHeight / 2); y++) {
+        int yOut = y;
+        m_handler->mapRow(yOut);
+        rows = std::max(rows, yOut + 1);
+    }
+    RunOnOutputWorkers(rows, [this, channelData, rowLen](int row) {
+        for (int output = 0; output < m_outputs; output++) {
+            int panelsOnOutput = m_panelMatrix->m_outputPanels[output].size();
         
-        for (int i = 0; i < panelsOnOutput; i++) {
-            int panel = m_panelMatrix->m_outputPanels[output][i];
-            int chain = m_panelMatrix->m_panels[panel].chain;
+            for (int i = 0; i < panelsOnOutput; i++) {
+                int panel = m_panelMatrix->m_outputPanels[output][i];
+                int chain = m_panelMatrix->m_panels[panel].chain;
             
-            for (int y = 0; y < (m_panelHeight / 2); y++) {
-                int yw1 = y * m_panelWidth * 3;
-                int yw2 = (y + (m_panelHeight / 2)) * m_panelWidth * 3;
+                for (int y = 0; y < (m_panelHeight / 2); y++) {
+                    int yw1 = y * m_panelWidth * 3;
+                    int yw2 = (y + (m_panelHeight / 2)) * m_panelWidth * 3;
 
                 
-                int yOut = y;
-                m_handler->mapRow(yOut);
-                int offset = yOut * rowLen * m_colorDepth + output * 2 * 3
-                    + (m_longestChain - chain - 1) * m_panelWidth/8 * m_outputs * 3 * 2 * m_panelHeight / (m_panelScan * 2);
+                    int yOut = y;
+                    m_handler->mapRow(yOut);
+                    if (yOut != row) {
+                        continue;
+                    }
+                    int offset = yOut * rowLen * m_colorDepth + output * 2 * 3
+                        + (m_longestChain - chain - 1) * m_panelWidth/8 * m_outputs * 3 * 2 * m_panelHeight / (m_panelScan * 2);
                 
-                for (int x = 0; x < m_panelWidth; ++x) {
-                    uint8_t r1 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw1 + x*3]]];
-                    uint8_t g1 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw1 + x*3 + 1]]];
-                    uint8_t b1 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw1 + x*3 + 2]]];
+                    for (int x = 0; x < m_panelWidth; ++x) {
+                        uint8_t r1 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw1 + x*3]]];
+                        uint8_t g1 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw1 + x*3 + 1]]];
+                        uint8_t b1 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw1 + x*3 + 2]]];
                     
-                    uint8_t r2 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw2 + x*3]]];
-                    uint8_t g2 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw2 + x*3 + 1]]];
-                    uint8_t b2 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw2 + x*3 + 2]]];
+                        uint8_t r2 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw2 + x*3]]];
+                        uint8_t g2 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw2 + x*3 + 1]]];
+                        uint8_t b2 = gammaCurve[channelData[m_panelMatrix->m_panels[panel].pixelMap[yw2 + x*3 + 2]]];
 
                     
-                    int xOut = x;
-                    m_handler->mapCol(y, xOut);
-                    int bitPos = 1 << (xOut % 8);
-                    int xOff = xOut / 8 * (m_outputs * 2 * 3);
+                        int xOut = x;
+                        m_handler->mapCol(y, xOut);
+                        int bitPos = 1 << (xOut % 8);
+                        int xOff = xOut / 8 * (m_outputs * 2 * 3);
                     
-                    for (int bit = 8; bit > (8-m_colorDepth); ) {
-                        --bit;
-                        uint8_t mask = 1 << bit;
-                        if (r1 & mask) {
-                            m_outputFrame[offset + xOff] |= bitPos;
-                        }
-                        if (g1 & mask) {
-                            m_outputFrame[offset + xOff + 1] |= bitPos;
-                        }
-                        if (b1 & mask) {
-                            m_outputFrame[offset + xOff + 2] |= bitPos;
+                        for (int bit = 8; bit > (8-m_colorDepth); ) {
+                            --bit;
+                            uint8_t mask = 1 << bit;
+                            if (r1 & mask) {
+                                m_outputFrame[offset + xOff] |= bitPos;
+                            }
+                            if (g1 & mask) {
+                                m_outputFrame[offset + xOff + 1] |= bitPos;
+                            }
+                            if (b1 & mask) {
+                                m_outputFrame[offset + xOff + 2] |= bitPos;
+                            }
+                            if (r2 & mask) {
+                                m_outputFrame[offset + xOff + 3] |= bitPos;
+                            }
+                            if (g2 & mask) {
+                                m_outputFrame[offset + xOff + 4] |= bitPos;
+                            }
+                            if (b2 & mask) {
+                                m_outputFrame[offset + xOff + 5] |= bitPos;
+                            }
+                            xOff += rowLen;
                         }
-                        if (r2 & mask) {
-                            m_outputFrame[offset + xOff + 3] |= bitPos;
-                        }
-                        if (g2 & mask) {
-                            m_outputFrame[offset + xOff + 4] |= bitPos;
-                        }
-                        if (b2 & mask) {
-                            m_outputFrame[offset + xOff + 5] |= bitPos;
-                        }
-                        xOff += rowLen;
                     }
                 }
             }
         }
-    }
+    });
 }
 int BBBMatrix::SendData(unsigned char *channelData)
 {
@@ -57,6 +57,7 @@ class BBBMatrix : public ChannelOutputBase {
     int Close(void);
     
     void PrepData(unsigned char *channelData);
+    bool PrepDataChangesChannelData(void) { return m_matrix && m_matrix->SubMatrixCount(); }
     
     int SendData(unsigned char *channelData);
     
@@ -23,6 +23,7 @@
  *   along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <vector>
 
 #include <errno.h>
@@ -98,3 +99,99 @@ void ChannelOutputBase::DumpConfig(void)
 	LogDebug(VB_CHANNELOUT, "    Start Channel    : %u\n", m_startChannel + 1);
 	LogDebug(VB_CHANNELOUT, "    Channel Count    : %u\n", m_channelCount);
 }
+
+
+ChangedDataTracker::ChangedDataTracker()
+  : m_sent(0),
+	m_skipped(0),
+	m_keepAlive(0),
+	m_repeats(0),
+	m_haveData(false),
+	m_pendingChanged(false),
+	m_lastSend(0)
+{
+}
+
+void ChangedDataTracker::Init(int keepAliveMS, const std::vector<std::pair<int, int>> &ranges)
+{
+	m_keepAlive = keepAliveMS;
+	m_ranges.clear();
+	m_haveData = false;
+	m_pendingChanged = false;
+	m_repeats = 0;
+	m_sent = 0;
+	m_skipped = 0;
+
+	int size = 0;
+	for (auto &r : ranges) {
+		int start = std::max(r.first, 0);
+		int end = std::min(r.first + r.second, FPPD_MAX_CHANNELS);
+		if (start < end) {
+			m_ranges.push_back(std::pair<int, int>(start, end - start));
+			size += end - start;
+		}
+	}
+	if (m_keepAlive > 0) {
+		m_lastData.resize(size);
+		m_pendingData.resize(size);
+	}
+}
+
+bool ChangedDataTracker::CheckData(const unsigned char *channelData, long long now)
+{
+	if (m_keepAlive <= 0)
+		return true;
+
+	// memcmp is vectorized by libc, so a straight compare is cheaper than
+	// hashing and the copy is only made when something changed
+	bool changed = !m_haveData;
+	int offset = 0;
+	for (auto &r : m_ranges) {
+		if (!changed && memcmp(&m_lastData[offset], channelData + r.first, r.second))
+			changed = true;
+		offset += r.second;
+	}
+
+	m_pendingChanged = changed;
+	if (changed) {
+		offset = 0;
+		for (auto &r : m_ranges) {
+			memcpy(&m_pendingData[offset], channelData + r.first, r.second);
+			offset += r.second;
+		}
+		return true;
+	}
+
+	if ((m_repeats > 0) || ((now - m_lastSend) >= (m_keepAlive * 1000LL)))
+		return true;
+
+	m_skipped++;
+	return false;
+}
+
+void ChangedDataTracker::DataSent(long long now)
+{
+	m_sent++;
+
+	if (m_keepAlive <= 0)
+		return;
+
+	if (m_pendingChanged) {
+		m_lastData.swap(m_pendingData);
+		m_pendingChanged = false;
+		m_haveData = true;
+		m_repeats = UNCHANGED_DATA_REPEATS;
+	} else if (m_repeats > 0) {
+		m_repeats--;
+	}
+	m_lastSend = now;
+}
+
+bool ChangedDataTracker::NeedToSend(const unsigned char *channelData, long long now)
+{
+	if (!CheckData(channelData, now))
+		return false;
+
+	DataSent(now);
+	return true;
+}
@@ -26,6 +26,7 @@
 #ifndef _CHANNELOUTPUTBASE_H
 #define _CHANNELOUTPUTBASE_H
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -34,6 +35,47 @@
 #include "channeloutput.h"
 #include "../Sequence.h"
 
+// Unchanged data is still sent this many times after it last changed in
+// case a packet was lost, as E1.31 asks for.
+#define UNCHANGED_DATA_REPEATS 3
+
+// Tracks whether blocks of channel data changed since they were last sent
+// so frames with no changes can be skipped.  Unchanged data is resent every
+// keep alive interval so receivers don't time out.
+class ChangedDataTracker {
+  public:
+	ChangedDataTracker();
+
+	// ranges are 0 based start channel and count, keepAliveMS <= 0
+	// sends every frame
+	void  Init(int keepAliveMS, const std::vector<std::pair<int, int>> &ranges);
+	bool  Enabled(void) { return m_keepAlive > 0; }
+	// send the next frame even if it didn't change
+	void  ForceSend(void) { m_haveData = false; }
+
+	// Returns whether channelData needs to be sent, DataSent() must be
+	// called once it has been.  channelData is the full frame.
+	bool  CheckData(const unsigned char *channelData, long long now);
+	void  DataSent(long long now);
+
+	// CheckData() and DataSent() together
+	bool  NeedToSend(const unsigned char *channelData, long long now);
+
+	unsigned long m_sent;
+	unsigned long m_skipped;
+
+  private:
+	int   m_keepAlive;
+	int   m_repeats;
+	bool  m_haveData;
+	bool  m_pendingChanged;
+	long long m_lastSend;
+
+	std::vector<std::pair<int, int>> m_ranges;
+	std::vector<unsigned char> m_lastData;
+	std::vector<unsigned char> m_pendingData;
+};
+
 class ChannelOutputBase {
   public:
 	ChannelOutputBase(unsigned int startChannel = 1,
@@ -49,10 +91,28 @@ class ChannelOutputBase {
 	virtual int   Close(void);
     
     virtual void  PrepData(unsigned char *channelData) {}
+    // outputs are prepared in parallel unless their PrepData changes the
+    // channel data, such as overlaying sub-matrices
+    virtual bool  PrepDataChangesChannelData(void) { return false; }
 	virtual int   SendData(unsigned char *channelData) = 0;
 
+    // with UnchangedDataKeepAlive set, PrepData and SendData are skipped
+    // for frames where none of the output's channels changed.  Only outputs
+    // whose devices hold the last data they were sent, such as network
+    // outputs, return true.  Serial and DMX devices need a steady refresh.
+    virtual bool  SkipUnchangedData(void) { return false; }
+    // counts for outputs that skip unchanged data themselves
+    virtual void  GetUnchangedDataStats(unsigned long &sent, unsigned long &skipped) {}
+
 
     virtual void  GetRequiredChannelRange(int &min, int & max) = 0;
+    // outputs with several disjoint blocks of channels (universes, etc)
+    // can report each block so only those channels get read
+    virtual void  GetRequiredChannelRanges(const std::function<void(int, int)> &addRange) {
+        int min, max;
+        GetRequiredChannelRange(min, max);
+        addRange(min, max);
+    }
   private:
 	int   Init(void);
 
@@ -80,6 +80,7 @@
 #include "common.h"
 #include "ColorLight-5a-75.h"
 #include "log.h"
+#include "OutputWorkers.h"
 
 
 /*
@@ -338,16 +339,12 @@ void ColorLight5a75Output::GetRequiredChannelRange(int &min, int & max) {
  */
 void ColorLight5a75Output::PrepData(unsigned char *channelData)
 {
-	unsigned char *r = NULL;
-	unsigned char *g = NULL;
-	unsigned char *b = NULL;
-	unsigned char *s = NULL;
-	unsigned char *dst = NULL;
 	int pw3 = m_panelWidth * 3;
 
 	channelData += m_startChannel; // FIXME, this function gets offset 0
 
-	for (int output = 0; output < m_outputs; output++) {
+	// each output fills its own rows of the frame
+	RunOnOutputWorkers(m_outputs, [this, channelData, pw3](int output) {
 		int panelsOnOutput = m_panelMatrix->m_outputPanels[output].size();
 
 		for (int i = 0; i < panelsOnOutput; i++) {
@@ -359,7 +356,7 @@ void ColorLight5a75Output::PrepData(unsigned char *channelData)
 				int px = chain * m_panelWidth;
 				int yw = y * m_panelWidth * 3;
 
-				dst = (unsigned char*)(m_outputFrame + (((((output * m_panelHeight) + y) * m_panelWidth * m_longestChain) + px) * 3));
+				unsigned char *dst = (unsigned char*)(m_outputFrame + (((((output * m_panelHeight) + y) * m_panelWidth * m_longestChain) + px) * 3));
 
 				for (int x = 0; x < pw3; x += 3)
 				{
@@ -371,7 +368,7 @@ void ColorLight5a75Output::PrepData(unsigned char *channelData)
 				}
 			}
 		}
-	}
+	});
 }
 
 /*
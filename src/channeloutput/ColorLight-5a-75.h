@@ -53,6 +53,9 @@ class ColorLight5a75Output : public ChannelOutputBase {
 
     virtual void GetRequiredChannelRange(int &min, int & max);
 
+    // sub-matrices come from channels outside the panel range
+    virtual bool SkipUnchangedData(void) { return !m_matrix || !m_matrix->SubMatrixCount(); }
+
   private:
 	void SetHostMACs(void *data);
 
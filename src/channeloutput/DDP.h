@@ -29,6 +29,9 @@
 #define DDP_PUSH_FLAG 0x01
 #define DDP_TIMECODE_FLAG 0x10
 
+// full refresh for receivers that drop out of realtime mode without data
+#define DDP_KEEP_ALIVE_MS 2000
+
 
 class DDPOutputData : public UDPOutputData {
 public:
@@ -39,6 +42,9 @@ public:
     virtual void PrepareData(unsigned char *channelData);
     virtual void CreateMessages(std::vector<struct mmsghdr> &ipMsgs);
     virtual void DumpConfig();
+
+    virtual int  DataStartChannel() { return (type == 5) ? 0 : startChannel - 1; }
+    virtual int  MaxKeepAliveMS() { return DDP_KEEP_ALIVE_MS; }
     
     char          sequenceNumber;
     
@@ -32,6 +32,8 @@
 #include "UDPOutput.h"
 #include "e131defs.h"
 
+#define E131_KEEP_ALIVE_MS 1000
+
 class E131OutputData : public UDPOutputData {
 public:
     E131OutputData(const Json::Value &config);
@@ -42,6 +44,9 @@ public:
     virtual void CreateMessages(std::vector<struct mmsghdr> &ipMsgs);
     virtual void DumpConfig();
 
+    // E1.31 sources resend unchanged data at least once a second
+    virtual int  MaxKeepAliveMS() { return E131_KEEP_ALIVE_MS; }
+
     int           universe;
     int           priority;
     char          E131sequenceNumber;
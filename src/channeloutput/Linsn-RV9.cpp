@@ -76,6 +76,7 @@
 #include "common.h"
 #include "Linsn-RV9.h"
 #include "log.h"
+#include "OutputWorkers.h"
 
 /*
  *
@@ -376,16 +377,12 @@ void LinsnRV9Output::GetRequiredChannelRange(int &min, int & max) {
  */
 void LinsnRV9Output::PrepData(unsigned char *channelData)
 {
-	unsigned char *r = NULL;
-	unsigned char *g = NULL;
-	unsigned char *b = NULL;
-	unsigned char *s = NULL;
-	unsigned char *dst = NULL;
 	int pw3 = m_panelWidth * 3;
 
 	channelData += m_startChannel; // FIXME, this function gets offset 0
 
-	for (int output = 0; output < m_outputs; output++)
+	// each output fills its own rows of the frame
+	RunOnOutputWorkers(m_outputs, [this, channelData, pw3](int output)
 	{
 		int panelsOnOutput = m_panelMatrix->m_outputPanels[output].size();
 
@@ -399,7 +396,7 @@ void LinsnRV9Output::PrepData(unsigned char *channelData)
 				int px = chain * m_panelWidth;
 				int yw = y * m_panelWidth * 3;
 
-				dst = (unsigned char*)(m_outputFrame + (((((output * m_panelHeight) + y) * m_formatCodes[m_formatIndex].width) + px) * 3) + m_formatCodes[m_formatIndex].dataOffset);
+				unsigned char *dst = (unsigned char*)(m_outputFrame + (((((output * m_panelHeight) + y) * m_formatCodes[m_formatIndex].width) + px) * 3) + m_formatCodes[m_formatIndex].dataOffset);
 
 				for (int x = 0; x < pw3; x += 3)
 				{
@@ -411,7 +408,7 @@ void LinsnRV9Output::PrepData(unsigned char *channelData)
 				}
 			}
 		}
-	}
+	});
 }
 
 /*
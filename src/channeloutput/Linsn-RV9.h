@@ -56,6 +56,9 @@ class LinsnRV9Output : public ChannelOutputBase {
 
     virtual void GetRequiredChannelRange(int &min, int & max);
 
+    // sub-matrices come from channels outside the panel range
+    virtual bool SkipUnchangedData(void) { return !m_matrix || !m_matrix->SubMatrixCount(); }
+
   private:
 	void HandShake(void);
 
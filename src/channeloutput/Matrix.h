@@ -48,6 +48,7 @@ class Matrix {
 
 	void OverlaySubMatrix(unsigned char *channelData, int i);
 	void OverlaySubMatrices(unsigned char *channelData);
+	int  SubMatrixCount(void) { return subMatrix.size(); }
 
   private:
 	int  m_startChannel;
@@ -46,6 +46,9 @@ class OLAOutput : public ThreadedChannelOutputBase {
 
 	void DumpConfig(void);
 
+	// olad keeps refreshing the universes itself
+	virtual bool SkipUnchangedData(void) { return true; }
+
   private:
 	ola::DmxBuffer                  m_buffer;
 	ola::client::StreamingClient   *m_client;
@@ -0,0 +1,173 @@
+/*
+ *   Output worker threads for the Falcon Player Daemon
+ *   Falcon Player project (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      Initial development by:
+ *      - David Pitts (dpitts)
+ *      - Tony Mace (MyKroFt)
+ *      - Mathew Mrosko (Materdaddy)
+ *      - Chris Pinkham (CaptainMurdoch)
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log.h"
+#include "OutputWorkers.h"
+#include "PlaybackThreads.h"
+#include "settings.h"
+
+static std::vector<std::thread *> workers;
+static bool workersRunning = false;
+
+// one batch of jobs runs at a time, the workers snapshot it under workLock
+static std::mutex workBatchLock;
+static std::mutex workLock;
+static std::condition_variable workCond;
+static std::condition_variable workDoneCond;
+static const std::function<void(int)> *workFunc = nullptr;
+static int workCount = 0;
+static std::atomic_int workNext(0);
+static int workDone = 0;
+static int workActive = 0;
+static unsigned int workGeneration = 0;
+
+// set while a thread is running jobs so nested calls run inline
+static thread_local bool inOutputWorker = false;
+
+static int RunOutputJobs(const std::function<void(int)> *func, int count) {
+    int done = 0;
+    int i;
+    while ((i = workNext++) < count) {
+        (*func)(i);
+        done++;
+    }
+    return done;
+}
+
+static void OutputWorkerThread(int worker) {
+    char name[16];
+    snprintf(name, sizeof(name), "fppd_prep%d", worker);
+    SetupPlaybackThread(name, PLAYBACK_THREAD_OUTPUT);
+
+    inOutputWorker = true;
+
+    std::unique_lock<std::mutex> lock(workLock);
+    unsigned int generation = workGeneration;
+    while (true) {
+        workCond.wait(lock, [&generation] { return !workersRunning || (generation != workGeneration); });
+        if (!workersRunning) {
+            break;
+        }
+        generation = workGeneration;
+
+        const std::function<void(int)> *func = workFunc;
+        int count = workCount;
+        workActive++;
+        lock.unlock();
+
+        int done = RunOutputJobs(func, count);
+
+        lock.lock();
+        workDone += done;
+        workActive--;
+        if (!workActive && (workDone == workCount)) {
+            workDoneCond.notify_one();
+        }
+    }
+}
+
+void InitOutputWorkers(void) {
+    if (!workers.empty()) {
+        return;
+    }
+
+    // 0 uses a thread per core, 1 prepares everything on the output thread
+    int threads = getSettingInt("ChannelOutputPrepThreads");
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads > OUTPUT_WORKERS_MAX) {
+        threads = OUTPUT_WORKERS_MAX;
+    }
+    if (threads <= 1) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(workLock);
+    workersRunning = true;
+    for (int x = 1; x < threads; x++) {
+        workers.push_back(new std::thread(OutputWorkerThread, x));
+    }
+    LogInfo(VB_CHANNELOUT, "Preparing channel outputs on %d threads\n", threads);
+}
+
+void CloseOutputWorkers(void) {
+    std::unique_lock<std::mutex> batchLock(workBatchLock);
+    std::unique_lock<std::mutex> lock(workLock);
+    workersRunning = false;
+    workCond.notify_all();
+    lock.unlock();
+
+    for (auto t : workers) {
+        t->join();
+        delete t;
+    }
+    workers.clear();
+}
+
+int OutputWorkerThreads(void) {
+    return workers.size() + 1;
+}
+
+void RunOnOutputWorkers(int count, const std::function<void(int)> &func) {
+    if ((count <= 1) || workers.empty() || inOutputWorker) {
+        for (int x = 0; x < count; x++) {
+            func(x);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> batchLock(workBatchLock);
+    std::unique_lock<std::mutex> lock(workLock);
+
+    // a worker that woke late for the last batch may still be checking in
+    workDoneCond.wait(lock, [] { return workActive == 0; });
+
+    workFunc = &func;
+    workCount = count;
+    workNext = 0;
+    workDone = 0;
+    workGeneration++;
+    workCond.notify_all();
+    lock.unlock();
+
+    inOutputWorker = true;
+    int done = RunOutputJobs(&func, count);
+    inOutputWorker = false;
+
+    lock.lock();
+    workDone += done;
+    workDoneCond.wait(lock, [count] { return !workActive && (workDone == count); });
+    workFunc = nullptr;
+}
@@ -0,0 +1,45 @@
+/*
+ *   Output worker threads for the Falcon Player Daemon
+ *   Falcon Player project (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      Initial development by:
+ *      - David Pitts (dpitts)
+ *      - Tony Mace (MyKroFt)
+ *      - Mathew Mrosko (Materdaddy)
+ *      - Chris Pinkham (CaptainMurdoch)
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _OUTPUTWORKERS_H
+#define _OUTPUTWORKERS_H
+
+#include <functional>
+
+// Persistent threads used to prepare the channel outputs in parallel.  The
+// thread asking for work runs jobs as well, so there is one less worker
+// than the number of threads used.
+#define OUTPUT_WORKERS_MAX 8
+
+void InitOutputWorkers(void);
+void CloseOutputWorkers(void);
+int  OutputWorkerThreads(void);
+
+// Run func(0) through func(count - 1) spread over the workers and return
+// once they have all finished.  Calls made from within a job run inline.
+void RunOnOutputWorkers(int count, const std::function<void(int)> &func);
+
+#endif /* _OUTPUTWORKERS_H */
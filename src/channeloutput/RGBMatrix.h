@@ -49,6 +49,7 @@ class RGBMatrixOutput : public ChannelOutputBase {
 	int Close(void);
 
 	void PrepData(unsigned char *channelData);
+	bool PrepDataChangesChannelData(void) { return m_matrix && m_matrix->SubMatrixCount(); }
 
 	int SendData(unsigned char *channelData);
 
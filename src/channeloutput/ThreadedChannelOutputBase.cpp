@@ -33,6 +33,7 @@
 #include "ThreadedChannelOutputBase.h"
 #include "common.h"
 #include "log.h"
+#include "PlaybackThreads.h"
 
 ThreadedChannelOutputBase::ThreadedChannelOutputBase(unsigned int startChannel,
 	 unsigned int channelCount)
@@ -216,6 +217,9 @@ void ThreadedChannelOutputBase::OutputThread(void)
 {
 	LogDebug(VB_CHANNELOUT, "ThreadedChannelOutputBase::OutputThread()\n");
 
+	std::string name = "fppd_" + m_outputType;
+	SetupPlaybackThread(name.c_str(), PLAYBACK_THREAD_OUTPUT);
+
 	long long wakeTime = GetTime();
 	struct timeval  tv;
 	struct timespec ts;
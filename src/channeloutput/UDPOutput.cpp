@@ -55,7 +55,7 @@ UDPOutputData::~UDPOutputData() {
 
 
 UDPOutput::UDPOutput(unsigned int startChannel, unsigned int channelCount)
-    : pingThread(nullptr), rebuildOutputLists(false)
+    : pingThread(nullptr), rebuildOutputLists(false), keepAliveMS(0), broadcastDataCount(0)
 {
     sendSocket = -1;
 }
@@ -93,6 +93,20 @@ int UDPOutput::Init(Json::Value config) {
         }
         
     }
+
+    // 0 sends every universe every frame
+    keepAliveMS = getSettingInt("UnchangedDataKeepAlive");
+    if (keepAliveMS > 0) {
+        for (auto o : outputs) {
+            int keepAlive = keepAliveMS;
+            if (o->MaxKeepAliveMS() && (keepAlive > o->MaxKeepAliveMS())) {
+                keepAlive = o->MaxKeepAliveMS();
+            }
+            std::vector<std::pair<int, int>> ranges;
+            ranges.push_back(std::pair<int, int>(o->DataStartChannel(), o->channelCount));
+            o->changes.Init(keepAlive, ranges);
+        }
+    }
     
     std::set<std::string> myIps;
     //get all the addresses
@@ -150,6 +164,15 @@ void  UDPOutput::GetRequiredChannelRange(int &min, int & max) {
         }
     }
 }
+void  UDPOutput::GetRequiredChannelRanges(const std::function<void(int, int)> &addRange) {
+    if (enabled) {
+        for (auto a : outputs) {
+            if (a->active) {
+                addRange(a->startChannel - 1, a->startChannel + a->channelCount - 2);
+            }
+        }
+    }
+}
 
 int UDPOutput::SendMessages(int socket, std::vector<struct mmsghdr> &sendmsgs) {
     errno = 0;
@@ -170,6 +193,42 @@ int UDPOutput::SendMessages(int socket, std::vector<struct mmsghdr> &sendmsgs) {
     return outputCount;
 }
 
+// Pick out the messages for the outputs whose data changed or needs a
+// keep alive.  Post data messages such as sync packets are only sent with
+// some data.
+void UDPOutput::SelectChangedMessages(unsigned char *channelData) {
+    changedUdpMsgs.clear();
+    changedBroadcastMsgs.clear();
+
+    long long now = GetMonotonicTime();
+    for (auto &m : outputMessages) {
+        if (!m.output->changes.NeedToSend(channelData, now)) {
+            continue;
+        }
+        changedUdpMsgs.insert(changedUdpMsgs.end(),
+                              udpMsgs.begin() + m.udpStart,
+                              udpMsgs.begin() + m.udpStart + m.udpCount);
+        changedBroadcastMsgs.insert(changedBroadcastMsgs.end(),
+                                    broadcastMsgs.begin() + m.broadcastStart,
+                                    broadcastMsgs.begin() + m.broadcastStart + m.broadcastCount);
+    }
+
+    if (!changedUdpMsgs.empty() || !changedBroadcastMsgs.empty()) {
+        changedBroadcastMsgs.insert(changedBroadcastMsgs.end(),
+                                    broadcastMsgs.begin() + broadcastDataCount,
+                                    broadcastMsgs.end());
+    }
+}
+
+void UDPOutput::GetUnchangedDataStats(unsigned long &sent, unsigned long &skipped) {
+    if (keepAliveMS > 0) {
+        for (auto o : outputs) {
+            sent += o->changes.m_sent;
+            skipped += o->changes.m_skipped;
+        }
+    }
+}
+
 int UDPOutput::SendData(unsigned char *channelData) {
     if (rebuildOutputLists) {
         RebuildOutputMessageLists();
@@ -178,15 +237,27 @@ int UDPOutput::SendData(unsigned char *channelData) {
     if ((udpMsgs.size() == 0 && broadcastMsgs.size() == 0) || !enabled) {
         return 0;
     }
+
+    std::vector<struct mmsghdr> *sendUdpMsgs = &udpMsgs;
+    std::vector<struct mmsghdr> *sendBroadcastMsgs = &broadcastMsgs;
+    if (keepAliveMS > 0) {
+        SelectChangedMessages(channelData);
+        sendUdpMsgs = &changedUdpMsgs;
+        sendBroadcastMsgs = &changedBroadcastMsgs;
+        if (sendUdpMsgs->empty() && sendBroadcastMsgs->empty()) {
+            return 1;
+        }
+    }
+
     std::chrono::high_resolution_clock clock;
     auto t1 = clock.now();
-    int outputCount = SendMessages(sendSocket, udpMsgs);
+    int outputCount = SendMessages(sendSocket, *sendUdpMsgs);
     auto t2 = clock.now();
     long diff = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
-    if ((outputCount != udpMsgs.size()) || (diff > 100)) {
+    if ((outputCount != sendUdpMsgs->size()) || (diff > 100)) {
         //failed to send all messages or it took more than 100ms to send them
         LogErr(VB_CHANNELOUT, "sendmmsg() failed for UDP output (output count: %d/%d   time: %u ms) with error: %d   %s\n",
-               outputCount, udpMsgs.size(), diff,
+               outputCount, sendUdpMsgs->size(), diff,
                errno,
                strerror(errno));
         
@@ -195,7 +266,7 @@ int UDPOutput::SendData(unsigned char *channelData) {
         PingControllers();
         return 0;
     }
-    outputCount = SendMessages(broadcastSocket, broadcastMsgs);
+    outputCount = SendMessages(broadcastSocket, *sendBroadcastMsgs);
     
     return 1;
 }
@@ -294,12 +365,24 @@ void UDPOutput::RebuildOutputMessageLists() {
     rebuildOutputLists = false;
     udpMsgs.clear();
     broadcastMsgs.clear();
+    outputMessages.clear();
     for (auto a : outputs) {
         if (a->valid && a->active) {
+            // controllers coming back online get the current data
+            a->changes.ForceSend();
+
+            OutputMessages m;
+            m.output = a;
+            m.udpStart = udpMsgs.size();
+            m.broadcastStart = broadcastMsgs.size();
             a->CreateMessages(udpMsgs);
             a->CreateBroadcastMessages(broadcastMsgs);
+            m.udpCount = udpMsgs.size() - m.udpStart;
+            m.broadcastCount = broadcastMsgs.size() - m.broadcastStart;
+            outputMessages.push_back(m);
         }
     }
+    broadcastDataCount = broadcastMsgs.size();
     //add any sync packets or whatever that are needed
     for (auto a : outputs) {
         if (a->valid && a->active) {
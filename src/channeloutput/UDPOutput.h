@@ -52,6 +52,11 @@ public:
     virtual void AddPostDataMessages(std::vector<struct mmsghdr> &bMsgs) {}
 
     virtual void DumpConfig() = 0;
+
+    // first channel of the data sent, 0 based
+    virtual int  DataStartChannel() { return startChannel - 1; }
+    // longest unchanged data can go without being resent, 0 for no limit
+    virtual int  MaxKeepAliveMS() { return 0; }
     
     std::string   description;
     bool          active;
@@ -60,6 +65,8 @@ public:
     int           type;
     std::string   ipAddress;
     bool          valid;
+
+    ChangedDataTracker changes;
 };
 
 
@@ -80,11 +87,17 @@ public:
     void BackgroundThreadPing();
 
     virtual void GetRequiredChannelRange(int &min, int & max);
+    virtual void GetRequiredChannelRanges(const std::function<void(int, int)> &addRange);
+
+    // unchanged universes are skipped individually
+    virtual bool SkipUnchangedData(void) { return false; }
+    virtual void GetUnchangedDataStats(unsigned long &sent, unsigned long &skipped);
 private:
     int SendMessages(int socket, std::vector<struct mmsghdr> &sendmsgs);
     bool InitNetwork();
     void PingControllers();
     void RebuildOutputMessageLists();
+    void SelectChangedMessages(unsigned char *channelData);
     
     int sendSocket;
     int broadcastSocket;
@@ -93,6 +106,20 @@ private:
     std::list<UDPOutputData*> outputs;
     std::vector<struct mmsghdr> udpMsgs;
     std::vector<struct mmsghdr> broadcastMsgs;
+
+    // the messages for each output so unchanged ones can be left out
+    struct OutputMessages {
+        UDPOutputData *output;
+        int udpStart;
+        int udpCount;
+        int broadcastStart;
+        int broadcastCount;
+    };
+    int keepAliveMS;
+    int broadcastDataCount;
+    std::vector<OutputMessages> outputMessages;
+    std::vector<struct mmsghdr> changedUdpMsgs;
+    std::vector<struct mmsghdr> changedBroadcastMsgs;
     
     std::thread *pingThread;
     volatile bool runDisabledPings;
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -47,6 +48,7 @@
 #include "HTTPVirtualDisplay.h"
 #include "Linsn-RV9.h"
 #include "log.h"
+#include "OutputWorkers.h"
 #include "Sequence.h"
 #include "settings.h"
 #include "LOR.h"
@@ -106,13 +108,67 @@ static int LoadOutputProcessors(void);
 OutputProcessors         outputProcessors;
 
 static std::vector<std::pair<uint32_t, uint32_t>> outputRanges;
-const std::vector<std::pair<uint32_t, uint32_t>> GetOutputRanges() {
+
+// Outputs whose PrepData changes the channel data are prepared first, the
+// rest are independent of each other and are prepared in parallel.
+static std::vector<int> serialPrepOutputs;
+static std::vector<int> parallelPrepOutputs;
+static long long        prepTimes[FPPD_MAX_CHANNEL_OUTPUTS];
+static long long        prepTimePeaks[FPPD_MAX_CHANNEL_OUTPUTS];
+static int              prepFrames = 0;
+
+// Outputs whose channels didn't change since they were last sent are
+// skipped, checked when the output would be prepared
+static ChangedDataTracker outputChanges[FPPD_MAX_CHANNEL_OUTPUTS];
+static bool               outputNeedsSend[FPPD_MAX_CHANNEL_OUTPUTS];
+const std::vector<std::pair<uint32_t, uint32_t>> &GetOutputRanges() {
     if (outputRanges.empty()) {
         outputRanges.push_back(std::pair<uint32_t, uint32_t>(0, FPPD_MAX_CHANNELS));
     }
     return outputRanges;
 }
 
+int GetChannelOutputCount(void) {
+    return channelOutputCount;
+}
+
+/*
+ * Sort the needed (first, last) channel ranges and merge any that overlap
+ * or are within mergeGap channels of each other into outputRanges.
+ */
+static void SetOutputRanges(const std::vector<std::pair<int, int>> &neededRanges, int mergeGap) {
+    std::vector<std::pair<int, int>> ranges;
+    for (auto &r : neededRanges) {
+        if (r.second >= r.first) {
+            ranges.push_back(r);
+        }
+    }
+    if (ranges.empty()) {
+        ranges.push_back(std::pair<int, int>(0, 0));
+    }
+    outputRanges.clear();
+    for (auto &r : ranges) {
+        // having the reads be aligned to intervals of 8 can help performance so
+        // we'll expand the ranges a bit to align things better
+        //round minimum down to interval of 8
+        if (r.first > 0) {
+            r.first--;
+        }
+        r.first &= 0xFFFFFFF8;
+        r.second += 8;
+        r.second &= 0xFFFFFFF8;
+        r.second -= 1;
+        r.first = std::max(r.first, 0);
+        r.second = std::min(r.second, FPPD_MAX_CHANNELS - 1);
+        outputRanges.push_back(std::pair<uint32_t, uint32_t>(r.first, r.second - r.first + 1));
+    }
+    MergeChannelRanges(outputRanges, mergeGap);
+
+    for (auto &r : outputRanges) {
+        LogInfo(VB_CHANNELOUT, "Determined range needed %d - %d\n", r.first, r.first + r.second - 1);
+    }
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -261,8 +317,7 @@ int InitializeChannelOutputs(void) {
 
 	// Reset index so we can start populating the outputs array
 	i = 0;
-    int maximumNeededChannel = 0;
-    int minimumNeededChannel = FPPD_MAX_CHANNELS;
+    std::vector<std::pair<int, int>> neededRanges;
 
 	if (FPDOutput.isConfigured())
 	{
@@ -277,8 +332,7 @@ int InitializeChannelOutputs(void) {
             LogInfo(VB_CHANNELOUT, "FPD:  Determined range needed %d - %d\n",
                     m1, m2);
             
-            minimumNeededChannel = std::min(minimumNeededChannel, m1);
-            maximumNeededChannel = std::max(maximumNeededChannel, m2);
+            neededRanges.push_back(std::pair<int, int>(m1, m2));
 
 			i++;
 			LogDebug(VB_CHANNELOUT, "Configured FPD Channel Output\n");
@@ -479,20 +533,18 @@ int InitializeChannelOutputs(void) {
                     int m2 = m1 + channelOutputs[i].channelCount - 1;
                     LogInfo(VB_CHANNELOUT, "%s %d:  Determined range needed %d - %d\n",
                             type.c_str(), i, m1, m2);
-                    minimumNeededChannel = std::min(minimumNeededChannel, m1);
-                    maximumNeededChannel = std::max(maximumNeededChannel, m2);
+                    neededRanges.push_back(std::pair<int, int>(m1, m2));
 					i++;
 				} else if ((channelOutputs[i].output) &&
 						   (((!csvConfig[0]) && (channelOutputs[i].output->Init(outputs[c]))) ||
 							((csvConfig[0]) && (channelOutputs[i].output->Init(csvConfig))))) {
                                
                                
-                    int m1, m2;
-                    channelOutputs[i].output->GetRequiredChannelRange(m1, m2);
-                    minimumNeededChannel = std::min(minimumNeededChannel, m1);
-                    maximumNeededChannel = std::max(maximumNeededChannel, m2);
-                    LogInfo(VB_CHANNELOUT, "%s %d:  Determined range needed %d - %d\n",
-                            type.c_str(), i, minimumNeededChannel, maximumNeededChannel);
+                    channelOutputs[i].output->GetRequiredChannelRanges([&neededRanges, &type, i](int m1, int m2) {
+                        LogInfo(VB_CHANNELOUT, "%s %d:  Determined range needed %d - %d\n",
+                                type.c_str(), i, m1, m2);
+                        neededRanges.push_back(std::pair<int, int>(m1, m2));
+                    });
 
                     i++;
 				} else {
@@ -509,28 +561,49 @@ int InitializeChannelOutputs(void) {
 
 	LogDebug(VB_CHANNELOUT, "%d Channel Outputs configured\n", channelOutputCount);
 
+	// 0 sends every frame to every output
+	int keepAlive = getSettingInt("UnchangedDataKeepAlive");
+
+	serialPrepOutputs.clear();
+	parallelPrepOutputs.clear();
+	for (i = 0; i < channelOutputCount; i++) {
+		outputNeedsSend[i] = true;
+		outputChanges[i].Init(0, std::vector<std::pair<int, int>>());
+
+		if (!channelOutputs[i].output)
+			continue;
+
+		// outputs that change the channel data while preparing it read
+		// channels outside their own ranges
+		if ((keepAlive > 0) && channelOutputs[i].output->SkipUnchangedData() &&
+			!channelOutputs[i].output->PrepDataChangesChannelData()) {
+			std::vector<std::pair<int, int>> ranges;
+			channelOutputs[i].output->GetRequiredChannelRanges([&ranges](int m1, int m2) {
+				ranges.push_back(std::pair<int, int>(m1, m2 - m1 + 1));
+			});
+			outputChanges[i].Init(keepAlive, ranges);
+		}
+
+		if (channelOutputs[i].output->PrepDataChangesChannelData())
+			serialPrepOutputs.push_back(i);
+		else
+			parallelPrepOutputs.push_back(i);
+	}
+	InitOutputWorkers();
+
 	LoadOutputProcessors();
-    int m1, m2;
-    outputProcessors.GetRequiredChannelRange(m1, m2);
-    minimumNeededChannel = std::min(minimumNeededChannel, m1);
-    maximumNeededChannel = std::max(maximumNeededChannel, m2);
-    if (maximumNeededChannel < minimumNeededChannel) {
-        maximumNeededChannel = minimumNeededChannel = 0;
-    }
-    // having the reads be aligned to intervals of 8 can help performance so
-    // we'll expand the range a bit to align things better
-    //round minimum down to interval of 8
-    if (minimumNeededChannel > 0) {
-        minimumNeededChannel--;
+    outputProcessors.GetRequiredChannelRanges([&neededRanges](int m1, int m2) {
+        neededRanges.push_back(std::pair<int, int>(m1, m2));
+    });
+
+    // ranges closer than this are read as one range, 0 for the default
+    int mergeGap = getSettingInt("OutputRangeMergeGap");
+    if (mergeGap == 0) {
+        mergeGap = OUTPUT_RANGE_MERGE_GAP;
+    } else if (mergeGap < 0) {
+        mergeGap = 0;
     }
-    minimumNeededChannel &= 0xFFFFFFF8;
-    maximumNeededChannel += 8;
-    maximumNeededChannel &= 0xFFFFFFF8;
-    maximumNeededChannel -= 1;
-    
-    outputRanges.push_back(std::pair<uint32_t, uint32_t>(minimumNeededChannel, maximumNeededChannel - minimumNeededChannel + 1));
-
-    LogInfo(VB_CHANNELOUT, "Determined range needed %d - %d\n", minimumNeededChannel, maximumNeededChannel);
+    SetOutputRanges(neededRanges, mergeGap);
 
 	return 1;
 }
@@ -552,14 +625,44 @@ void ResetChannelOutputFrameNumber(void) {
 }
 
 
+static void PrepOutput(int i, char *channelData) {
+    long long startTime = GetTime();
+
+    if (outputChanges[i].Enabled()) {
+        outputNeedsSend[i] = outputChanges[i].CheckData((unsigned char *)channelData, GetMonotonicTime());
+        if (!outputNeedsSend[i])
+            return;
+    }
+
+    channelOutputs[i].output->PrepData((unsigned char *)channelData);
+    long long prepTime = GetTime() - startTime;
+
+    prepTimes[i] += prepTime;
+    if (prepTime > prepTimePeaks[i])
+        prepTimePeaks[i] = prepTime;
+}
+
 int PrepareChannelData(char *channelData) {
     outputProcessors.ProcessData((unsigned char *)channelData);
-    FPPChannelOutputInstance *inst;
-    for (int i = 0; i < channelOutputCount; i++) {
-        inst = &channelOutputs[i];
-        if (inst->output) {
-            inst->output->PrepData((unsigned char *)channelData);
+
+    for (auto i : serialPrepOutputs) {
+        PrepOutput(i, channelData);
+    }
+    RunOnOutputWorkers(parallelPrepOutputs.size(), [channelData](int x) {
+        PrepOutput(parallelPrepOutputs[x], channelData);
+    });
+
+    if (++prepFrames == OUTPUT_PREP_STATS_FRAMES) {
+        for (int i = 0; i < channelOutputCount; i++) {
+            if (channelOutputs[i].output) {
+                LogDebug(VB_CHANNELOUT, "Output %d PrepData avg: %lldus, peak: %lldus, sent: %lu, skipped: %lu\n",
+                         i, prepTimes[i] / prepFrames, prepTimePeaks[i],
+                         outputChanges[i].m_sent, outputChanges[i].m_skipped);
+            }
+            prepTimes[i] = 0;
+            prepTimePeaks[i] = 0;
         }
+        prepFrames = 0;
     }
     return 0;
 }
@@ -567,7 +670,7 @@ int PrepareChannelData(char *channelData) {
 /*
  *
  */
-int SendChannelData(const char *channelData) {
+int SendChannelData(const char *channelData, int countFrame) {
 	int i = 0;
 	FPPChannelOutputInstance *inst;
 
@@ -586,17 +689,48 @@ int SendChannelData(const char *channelData) {
                     channelData + inst->startChannel,
                     inst->channelCount < (FPPD_MAX_CHANNELS - inst->startChannel) ? inst->channelCount : (FPPD_MAX_CHANNELS - inst->startChannel));
         } else if (inst->output) {
+            if (!outputNeedsSend[i])
+                continue;
+
             inst->output->SendData((unsigned char *)(channelData + inst->startChannel));
+            outputChanges[i].DataSent(GetMonotonicTime());
         }
     }
 
+	if (countFrame)
+		IncrementChannelOutputFrame();
+
+    return 0;
+}
+
+/*
+ * Totals of the output frames and universes sent and skipped because
+ * their data hadn't changed
+ */
+void GetUnchangedDataStats(unsigned long &sent, unsigned long &skipped) {
+	sent = 0;
+	skipped = 0;
+	for (int i = 0; i < channelOutputCount; i++) {
+		if (!channelOutputs[i].output)
+			continue;
+
+		if (outputChanges[i].Enabled()) {
+			sent += outputChanges[i].m_sent;
+			skipped += outputChanges[i].m_skipped;
+		}
+		channelOutputs[i].output->GetUnchangedDataStats(sent, skipped);
+	}
+}
 
+/*
+ * Count a frame as sent
+ */
+void IncrementChannelOutputFrame(void) {
 	channelOutputFrame++;
 
 	// Reset channelOutputFrame every week @ 50ms timing
 	if (channelOutputFrame > 12096000)
 		channelOutputFrame = 0;
-    return 0;
 }
 
 /*
@@ -633,6 +767,10 @@ void StopOutputThreads(void) {
 int CloseChannelOutputs(void) {
 	int i = 0;
 
+	CloseOutputWorkers();
+	serialPrepOutputs.clear();
+	parallelPrepOutputs.clear();
+
 	for (i = 0; i < channelOutputCount; i++) {
 		if (channelOutputs[i].outputOld)
 			channelOutputs[i].outputOld->close(channelOutputs[i].privData);
@@ -32,6 +32,12 @@
 
 #define FPPD_MAX_CHANNEL_OUTPUTS   64
 
+// needed channel ranges closer than this are merged into one read
+#define OUTPUT_RANGE_MERGE_GAP     1024
+
+// PrepData times for each output are logged every this many frames
+#define OUTPUT_PREP_STATS_FRAMES   1000
+
 class ChannelOutputBase;
 class OutputProcessors;
 
@@ -62,13 +68,17 @@ extern OutputProcessors outputProcessors;
 
 int  InitializeChannelOutputs(void);
 int  PrepareChannelData(char *channelData);
-int  SendChannelData(const char *channelData);
+// countFrame is 0 for extra frames sent between sequence frames
+int  SendChannelData(const char *channelData, int countFrame = 1);
 int  CloseChannelOutputs(void);
 void SetChannelOutputFrameNumber(int frameNumber);
+void IncrementChannelOutputFrame(void);
+void GetUnchangedDataStats(unsigned long &sent, unsigned long &skipped);
 void ResetChannelOutputFrameNumber(void);
 void StartOutputThreads(void);
 void StopOutputThreads(void);
 
-const std::vector<std::pair<uint32_t, uint32_t>> GetOutputRanges();
+const std::vector<std::pair<uint32_t, uint32_t>> &GetOutputRanges();
+int  GetChannelOutputCount(void);
 
 #endif /* _CHANNELOUTPUT_H */
@@ -27,17 +27,22 @@
 #include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "channeloutput.h"
+#include "channeloutputthread.h"
 #include "common.h"
 #include "effects.h"
 #include "fppd.h"
 #include "log.h"
 #include "MultiSync.h"
 #include "PixelOverlay.h"
+#include "PlaybackThreads.h"
+#include "SequenceLayer.h"
 #include "Sequence.h"
 #include "settings.h"
 
@@ -58,7 +63,33 @@ int       ThreadIsRunning = 0;
 
 pthread_mutex_t  outputThreadLock;
 pthread_cond_t   outputThreadCond;
-
+volatile int     ForceOutput = 0;
+
+/* frame timing stats since the output thread started */
+static unsigned long OutputFrameCount = 0;
+static unsigned long LateFrames = 0;
+static unsigned long Overruns = 0;
+static long long     JitterTotal = 0;
+static int           JitterPeak = 0;
+
+
+/* output pipeline, enough slots for a frame period of interpolated frames */
+#define OUTPUT_PIPELINE_SLOTS (SEQUENCE_INTERPOLATION_MAX + 2)
+
+typedef struct {
+	char      *data;
+	long long  sendTime;
+} OutputPipelineFrame;
+
+static int                 UsePipeline = 0;
+static OutputPipelineFrame PipelineFrames[OUTPUT_PIPELINE_SLOTS];
+static unsigned int        PipelineHead = 0;
+static unsigned int        PipelineTail = 0;
+static int                 PipelineRunThread = 0;
+static int                 PipelineThreadIsRunning = 0;
+static pthread_t           PipelineThreadID;
+static pthread_mutex_t     PipelineLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t      PipelineCond = PTHREAD_COND_INITIALIZER;
 
 /* prototypes for functions below */
 void CalculateNewChannelOutputDelayForFrame(int expectedFramesSent);
@@ -88,11 +119,216 @@ void EnableChannelOutput(void) {
 
 void ForceChannelOutputNow(void) {
     LogDebug(VB_CHANNELOUT, "ForceChannelOutputNow()\n");
+    ForceOutput = 1;
     pthread_cond_signal(&outputThreadCond);
 }
 
 
 
+/*
+ * Sleep until the monotonic wakeTime unless output is forced sooner.
+ * Returns 1 if output was forced.  Assumes outputThreadLock is held.
+ */
+static int WaitForOutputTime(long long wakeTime)
+{
+	struct timespec ts;
+
+	ts.tv_sec = wakeTime / 1000000;
+	ts.tv_nsec = (wakeTime % 1000000) * 1000;
+
+	while (!ForceOutput && RunThread && (GetMonotonicTime() < wakeTime)) {
+		if (pthread_cond_timedwait(&outputThreadCond, &outputThreadLock, &ts) == ETIMEDOUT)
+			break;
+	}
+
+	if (ForceOutput) {
+		ForceOutput = 0;
+		LogDebug(VB_CHANNELOUT, "Forced output\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Allocate the output pipeline frames if the pipeline is enabled.  Called
+ * once at startup before any data is sent.
+ */
+void InitOutputPipeline(void)
+{
+	if (!getSettingInt("ChannelOutputPipeline"))
+		return;
+
+	for (int i = 0; i < OUTPUT_PIPELINE_SLOTS; i++) {
+		PipelineFrames[i].data = (char *)calloc(1, FPPD_MAX_CHANNELS);
+		if (!PipelineFrames[i].data) {
+			LogErr(VB_CHANNELOUT, "Unable to allocate output pipeline frames\n");
+			CloseOutputPipeline();
+			return;
+		}
+	}
+
+	LogInfo(VB_CHANNELOUT, "Output pipeline enabled, outputs are %d frame behind the sequence\n",
+		OUTPUT_PIPELINE_FRAMES);
+	UsePipeline = 1;
+}
+
+void CloseOutputPipeline(void)
+{
+	UsePipeline = 0;
+
+	for (int i = 0; i < OUTPUT_PIPELINE_SLOTS; i++) {
+		free(PipelineFrames[i].data);
+		PipelineFrames[i].data = NULL;
+	}
+}
+
+int UsingOutputPipeline(void)
+{
+	return UsePipeline;
+}
+
+/*
+ * Microseconds between a frame being queued and sent
+ */
+int GetOutputPipelineLatency(void)
+{
+	return UsePipeline ? DefaultLightDelay * OUTPUT_PIPELINE_FRAMES : 0;
+}
+
+static void CopyOutputRanges(char *dest, const char *channelData)
+{
+	for (auto &r : GetOutputRanges())
+		memcpy(dest + r.first, channelData + r.first, r.second);
+}
+
+/*
+ * Queue a copy of unprepared channel data to be prepared and sent by the
+ * pipeline thread.  If the output thread isn't running then the copy is
+ * prepared and sent now.
+ */
+int QueueChannelData(const char *channelData, int countFrame)
+{
+	pthread_mutex_lock(&PipelineLock);
+
+	if (!PipelineThreadIsRunning) {
+		char *data = PipelineFrames[PipelineHead % OUTPUT_PIPELINE_SLOTS].data;
+
+		CopyOutputRanges(data, channelData);
+		PrepareChannelData(data);
+		SendChannelData(data, countFrame);
+
+		pthread_mutex_unlock(&PipelineLock);
+		return 0;
+	}
+
+	// The pipeline thread is more than a frame behind, wait for a slot
+	while ((PipelineHead - PipelineTail) >= OUTPUT_PIPELINE_SLOTS)
+		pthread_cond_wait(&PipelineCond, &PipelineLock);
+
+	OutputPipelineFrame *frame = &PipelineFrames[PipelineHead % OUTPUT_PIPELINE_SLOTS];
+
+	CopyOutputRanges(frame->data, channelData);
+	frame->sendTime = GetMonotonicTime() + GetOutputPipelineLatency();
+	PipelineHead++;
+
+	pthread_cond_broadcast(&PipelineCond);
+	pthread_mutex_unlock(&PipelineLock);
+
+	// Frames are counted when queued so the sync code sees the frame the
+	// output thread is working on, as it does without the pipeline
+	if (countFrame)
+		IncrementChannelOutputFrame();
+
+	return 0;
+}
+
+/*
+ * Pipeline thread, prepares and sends the queued frames in order.  The
+ * outputs only hold the prepared data for one frame so a frame can't be
+ * prepared until the one before it has been sent.
+ */
+static void *RunOutputPipelineThread(void *data)
+{
+	(void)data;
+
+	LogDebug(VB_CHANNELOUT, "RunOutputPipelineThread() starting\n");
+
+	SetupPlaybackThread("fppd_pipeline", PLAYBACK_THREAD_OUTPUT);
+
+	pthread_mutex_lock(&PipelineLock);
+	while (PipelineRunThread || (PipelineHead != PipelineTail)) {
+		if (PipelineHead == PipelineTail) {
+			pthread_cond_wait(&PipelineCond, &PipelineLock);
+			continue;
+		}
+
+		OutputPipelineFrame *frame = &PipelineFrames[PipelineTail % OUTPUT_PIPELINE_SLOTS];
+		pthread_mutex_unlock(&PipelineLock);
+
+		long long prepTime = GetMonotonicTime();
+		PrepareChannelData(frame->data);
+
+		long long sendTime = GetMonotonicTime();
+		if (frame->sendTime > sendTime) {
+			struct timespec ts;
+			ts.tv_sec = frame->sendTime / 1000000;
+			ts.tv_nsec = (frame->sendTime % 1000000) * 1000;
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+				;
+		} else
+			LogExcess(VB_CHANNELOUT, "Output pipeline frame %lldus late, prep took %lldus\n",
+				sendTime - frame->sendTime, sendTime - prepTime);
+
+		SendChannelData(frame->data, 0);
+
+		pthread_mutex_lock(&PipelineLock);
+		PipelineTail++;
+		pthread_cond_broadcast(&PipelineCond);
+	}
+	pthread_mutex_unlock(&PipelineLock);
+
+	LogDebug(VB_CHANNELOUT, "RunOutputPipelineThread() completed\n");
+
+	return NULL;
+}
+
+static void StartOutputPipelineThread(void)
+{
+	if (!UsePipeline)
+		return;
+
+	pthread_mutex_lock(&PipelineLock);
+	PipelineRunThread = 1;
+	int result = pthread_create(&PipelineThreadID, NULL, &RunOutputPipelineThread, NULL);
+	if (result)
+		LogErr(VB_CHANNELOUT, "ERROR creating output pipeline thread: %s\n", strerror(result));
+	else
+		PipelineThreadIsRunning = 1;
+	pthread_mutex_unlock(&PipelineLock);
+}
+
+/*
+ * Stop the pipeline thread once the queued frames have been sent
+ */
+static void StopOutputPipelineThread(void)
+{
+	pthread_mutex_lock(&PipelineLock);
+	if (!PipelineThreadIsRunning) {
+		pthread_mutex_unlock(&PipelineLock);
+		return;
+	}
+	PipelineRunThread = 0;
+	pthread_cond_broadcast(&PipelineCond);
+	pthread_mutex_unlock(&PipelineLock);
+
+	pthread_join(PipelineThreadID, NULL);
+
+	pthread_mutex_lock(&PipelineLock);
+	PipelineThreadIsRunning = 0;
+	pthread_mutex_unlock(&PipelineLock);
+}
+
 /*
  * Main loop in channel output thread
  */
@@ -102,21 +338,33 @@ void *RunChannelOutputThread(void *data)
 
 	static long long lastStatTime = 0;
 	long long startTime;
+	long long frameTime;
+	long long nextFrameTime;
 	long long sendTime;
 	long long readTime;
     long long processTime;
 	int onceMore = 0;
-	struct timespec ts;
-    struct timeval tv;
+	int forced = 1;
+	int jitter = 0;
 	int syncFrameCounter = 99; //set high so first frame sends sync immediately
 
 	LogDebug(VB_CHANNELOUT, "RunChannelOutputThread() starting\n");
 
+	SetupPlaybackThread("fppd_output", PLAYBACK_THREAD_OUTPUT);
+
 	ThreadIsRunning = 1;
+	OutputFrameCount = 0;
+	LateFrames = 0;
+	Overruns = 0;
+	JitterTotal = 0;
+	JitterPeak = 0;
+
     StartOutputThreads();
+	StartOutputPipelineThread();
 
 	if ((getFPPmode() == REMOTE_MODE) &&
 		(!IsEffectRunning()) &&
+		(!IsSequenceLayerRunning()) &&
 		(!UsingMemoryMapInput()) &&
 		(!channelTester->Testing()) &&
 		(!getAlwaysTransmit()))
@@ -136,8 +384,30 @@ void *RunChannelOutputThread(void *data)
 
     pthread_mutex_lock(&outputThreadLock);
 
+	nextFrameTime = GetMonotonicTime();
+
 	while (RunThread) {
-		startTime = GetTime();
+		startTime = GetMonotonicTime();
+
+		// Frames are scheduled from the previous frame's deadline so
+		// wakeup latency doesn't accumulate, a forced output starts
+		// the cadence over from now.
+		if (forced) {
+			frameTime = startTime;
+			jitter = 0;
+		} else {
+			frameTime = nextFrameTime;
+			jitter = (int)(startTime - frameTime);
+			if (jitter < 0)
+				jitter = 0;
+
+			OutputFrameCount++;
+			JitterTotal += jitter;
+			if (jitter > JitterPeak)
+				JitterPeak = jitter;
+			if (jitter > OUTPUT_LATE_FRAME_US)
+				LateFrames++;
+		}
 
 		if ((getFPPmode() == MASTER_MODE) &&
 			(sequence->IsSequenceRunning())) {
@@ -145,11 +415,17 @@ void *RunChannelOutputThread(void *data)
              // to help speed up the initial syncs
             int syncFrameCounterMax = channelOutputFrame < 32 ? 4 : 16;
 			if (syncFrameCounter >= syncFrameCounterMax) {
+				// remotes sync to the frame being sent, not the one
+				// being queued to the output pipeline
+				int syncFrame = channelOutputFrame;
+				if (UsePipeline)
+					syncFrame = (syncFrame > OUTPUT_PIPELINE_FRAMES) ? syncFrame - OUTPUT_PIPELINE_FRAMES : 0;
+
 				syncFrameCounter = 1;
 				multiSync->SendSeqSyncPacket(
-					sequence->m_seqFilename, channelOutputFrame,
+					sequence->m_seqFilename, syncFrame,
 					(mediaElapsedSeconds > 0) ? mediaElapsedSeconds
-						: 1.0 * channelOutputFrame / RefreshRate );
+						: 1.0 * syncFrame / RefreshRate );
 			} else {
 				syncFrameCounter++;
 			}
@@ -172,7 +448,7 @@ void *RunChannelOutputThread(void *data)
 			sequence->SendSequenceData();
         }
 
-		sendTime = GetTime();
+		sendTime = GetMonotonicTime();
 
         if (getFPPmode() != BRIDGE_MODE) {
             if (FrameSkip) {
@@ -182,13 +458,14 @@ void *RunChannelOutputThread(void *data)
             sequence->ReadSequenceData();
         }
 
-        readTime = GetTime();
+        readTime = GetMonotonicTime();
 		sequence->ProcessSequenceData(1000.0 * channelOutputFrame / RefreshRate, 1);
 
-		processTime = GetTime();
+		processTime = GetMonotonicTime();
 
 		if ((sequence->IsSequenceRunning()) ||
 			(IsEffectRunning()) ||
+			(IsSequenceLayerRunning()) ||
 			(UsingMemoryMapInput()) ||
 			(channelTester->Testing()) ||
 			(getAlwaysTransmit()) ||
@@ -205,12 +482,13 @@ void *RunChannelOutputThread(void *data)
                     lastStatTime = startTime;
                 }
 				LogDebug(VB_CHANNELOUT,
-                         "Output Thread: Loop: %dus, Send: %lldus, Read: %lldus, Process: %lldus, Sleep: %dus, FrameNum: %ld\n",
+                         "Output Thread: Loop: %dus, Send: %lldus, Read: %lldus, Process: %lldus, Sleep: %dus, Jitter: %dus, FrameNum: %ld, Late: %lu, Overruns: %lu\n",
 					LightDelay,
                     sendTime - startTime,
 					readTime - sendTime,
                     processTime - readTime, 
-                    sleepTime, channelOutputFrame);
+                    sleepTime, jitter, channelOutputFrame,
+					LateFrames, Overruns);
 			}
 		}
 		else
@@ -223,26 +501,36 @@ void *RunChannelOutputThread(void *data)
 				RunThread = 0;
 		}
 
-		// Calculate how long we need to nanosleep()
-		long dt = (LightDelay - (GetTime() - startTime)) * 1000;
-		if (dt > 0)
-		{
-			gettimeofday(&tv, NULL);
-			ts.tv_sec = tv.tv_sec;
-			ts.tv_nsec = tv.tv_usec * 1000 + dt;
-
-			if (ts.tv_nsec >= 1000000000)
-			{
-				ts.tv_sec  += 1;
-				ts.tv_nsec -= 1000000000;
+		// Send the frames blended between the last sequence frame and
+		// the one that was just read
+		if (OutputFrames && sequence->IsSequenceRunning()) {
+			int steps = sequence->GetInterpolationSteps();
+			for (int i = 1; (i < steps) && RunThread; i++) {
+				if (WaitForOutputTime(frameTime + (long long)LightDelay * i / steps)) {
+					// forced output, send the next real frame now
+					ForceOutput = 1;
+					break;
+				}
+				sequence->SendInterpolatedData(i);
 			}
+		}
 
-			if (pthread_cond_timedwait(&outputThreadCond, &outputThreadLock, &ts) != ETIMEDOUT) {
-				LogDebug(VB_CHANNELOUT, "Forced output\n");
-			}
-        }
+		nextFrameTime = frameTime + LightDelay;
+
+		// If a whole frame has been missed, start over from now rather
+		// than sending a burst of frames to catch up
+		long long now = GetMonotonicTime();
+		if (now >= (nextFrameTime + LightDelay)) {
+			Overruns++;
+			LogExcess(VB_CHANNELOUT, "Output overrun, %lldus behind, FrameNum: %ld\n",
+				now - nextFrameTime, channelOutputFrame);
+			nextFrameTime = now;
+		}
+
+		forced = WaitForOutputTime(nextFrameTime);
 	}
 
+	StopOutputPipelineThread();
 	StopOutputThreads();
     pthread_mutex_unlock(&outputThreadLock);
 
@@ -253,6 +541,19 @@ void *RunChannelOutputThread(void *data)
 	pthread_exit(NULL);
 }
 
+/*
+ * Frame timing stats since the output thread was last started
+ */
+void GetChannelOutputTiming(unsigned long &frames, unsigned long &lateFrames,
+                            unsigned long &overruns, int &jitterAvg, int &jitterPeak)
+{
+	frames = OutputFrameCount;
+	lateFrames = LateFrames;
+	overruns = Overruns;
+	jitterAvg = frames ? (int)(JitterTotal / frames) : 0;
+	jitterPeak = JitterPeak;
+}
+
 /*
  * Set the step time
  */
@@ -270,7 +571,13 @@ int StartChannelOutputThread(void)
 	LogDebug(VB_CHANNELOUT, "StartChannelOutputThread()\n");
     
     pthread_mutex_init(&outputThreadLock, NULL);
-    pthread_cond_init(&outputThreadCond, NULL);
+
+	// the output loop waits on absolute CLOCK_MONOTONIC deadlines
+	pthread_condattr_t condAttr;
+	pthread_condattr_init(&condAttr);
+	pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&outputThreadCond, &condAttr);
+	pthread_condattr_destroy(&condAttr);
 
 	int E131BridgingInterval = getSettingInt("E131BridgingInterval");
 
@@ -369,6 +676,12 @@ void ResetMasterPosition(void)
 void UpdateMasterPosition(int frameNumber)
 {
 	MasterFramesPlayed = frameNumber;
+
+	// keep the output pipeline far enough ahead that our lights show
+	// the master's frame at the same time
+	if (UsePipeline)
+		frameNumber += OUTPUT_PIPELINE_FRAMES;
+
 	CalculateNewChannelOutputDelayForFrame(frameNumber);
 }
 
@@ -393,6 +706,9 @@ void CalculateNewChannelOutputDelay(float mediaPosition)
 
 	int expectedFramesSent = (int)(offsetMediaPosition * RefreshRate);
 
+	if (UsePipeline)
+		expectedFramesSent += OUTPUT_PIPELINE_FRAMES;
+
 	mediaElapsedSeconds = mediaPosition;
 
 	LogDebug(VB_CHANNELOUT,
@@ -40,4 +40,21 @@ void ResetMasterPosition(void);
 void UpdateMasterPosition(int frameNumber);
 void CalculateNewChannelOutputDelay(float mediaPosition);
 
+// Frames starting more than this long after their deadline count as late
+#define OUTPUT_LATE_FRAME_US 2000
+
+void GetChannelOutputTiming(unsigned long &frames, unsigned long &lateFrames,
+                            unsigned long &overruns, int &jitterAvg, int &jitterPeak);
+
+// With the output pipeline enabled, frames are prepared and sent by their
+// own thread one frame period after being queued so the output thread can
+// read and overlay the next frame at the same time.
+#define OUTPUT_PIPELINE_FRAMES 1
+
+void InitOutputPipeline(void);
+void CloseOutputPipeline(void);
+int  UsingOutputPipeline(void);
+int  GetOutputPipelineLatency(void);
+int  QueueChannelData(const char *channelData, int countFrame = 1);
+
 #endif
@@ -44,6 +44,11 @@ public:
     virtual void GetRequiredChannelRange(int &min, int & max) {
         min = 0; max = FPPD_MAX_CHANNELS;
     }
+    virtual void GetRequiredChannelRanges(const std::function<void(int, int)> &addRange) {
+        int min, max;
+        GetRequiredChannelRange(min, max);
+        addRange(min, max);
+    }
 protected:
     std::string description;
     bool active;
@@ -65,6 +70,7 @@ public:
     void loadFromJSON(const Json::Value &config, bool clear = true);
     
     void GetRequiredChannelRange(int &min, int & max);
+    void GetRequiredChannelRanges(const std::function<void(int, int)> &addRange);
 protected:
     void removeAll();
     OutputProcessor *create(const Json::Value &config);
@@ -45,8 +45,10 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <ctype.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <sstream>
 
 #include "common.h"
@@ -62,6 +64,17 @@ long long GetTime(void)
 	return now_tv.tv_sec * 1000000LL + now_tv.tv_usec;
 }
 
+/*
+ * Get the time in microseconds from a clock that isn't affected by changes
+ * to the system time, for measuring intervals and scheduling
+ */
+long long GetMonotonicTime(void)
+{
+	struct timespec now_ts;
+	clock_gettime(CLOCK_MONOTONIC, &now_ts);
+	return now_ts.tv_sec * 1000000LL + now_ts.tv_nsec / 1000;
+}
+
 /*
  * Check to see if the specified directory exists
  */
@@ -458,6 +471,52 @@ std::vector<std::string> split(const std::string &s, char delim) {
     return elems;
 }
 
+/*
+ * Sort (start, count) channel ranges and merge any that overlap or are
+ * within maxGap channels of each other
+ */
+void MergeChannelRanges(std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t maxGap)
+{
+    if (ranges.empty())
+        return;
+
+    std::sort(ranges.begin(), ranges.end());
+
+    size_t out = 0;
+    for (size_t i = 1; i < ranges.size(); i++) {
+        uint64_t end = (uint64_t)ranges[out].first + ranges[out].second;
+        if (ranges[i].first <= (end + maxGap)) {
+            uint64_t newEnd = std::max(end, (uint64_t)ranges[i].first + ranges[i].second);
+            ranges[out].second = newEnd - ranges[out].first;
+        } else {
+            ranges[++out] = ranges[i];
+        }
+    }
+    ranges.resize(out + 1);
+}
+
+/*
+ * Parse a comma separated list of first-last channel ranges where the
+ * first channel is numbered firstChannel (0 or 1) into sorted and merged
+ * 0 based (start, count) ranges.  Invalid entries are skipped.
+ */
+std::vector<std::pair<uint32_t, uint32_t>> ParseChannelRanges(const std::string &str, int firstChannel)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+    for (auto &p : split(str, ',')) {
+        int first, last;
+        if ((sscanf(p.c_str(), "%d-%d", &first, &last) == 2) &&
+            (first >= firstChannel) && (last >= first)) {
+            ranges.push_back(std::pair<uint32_t, uint32_t>(first - firstChannel, last - first + 1));
+        }
+    }
+
+    MergeChannelRanges(ranges);
+
+    return ranges;
+}
+
 
 /*
  * Merge the contens of Json::Value b into Json::Value a
@@ -66,6 +66,7 @@
 
 
 long long GetTime(void);
+long long GetMonotonicTime(void);
 int       DirectoryExists(const char * Directory);
 int       FileExists(const char * File);
 int       FileExists(const std::string &File);
@@ -89,4 +90,7 @@ std::string tail(std::string const& source, size_t const length);
 std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems);
 std::vector<std::string> split(const std::string &s, char delim);
 
+void MergeChannelRanges(std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t maxGap = 0);
+std::vector<std::pair<uint32_t, uint32_t>> ParseChannelRanges(const std::string &str, int firstChannel = 0);
+
 #endif
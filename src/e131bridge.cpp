@@ -35,9 +35,17 @@
 #include <unistd.h>
 #include <ifaddrs.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <list>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+
+#include <boost/algorithm/string/predicate.hpp>
 
 #include <jsoncpp/json/json.h>
 
@@ -46,6 +54,7 @@
 #include "common.h"
 #include "DDP.h"
 #include "e131bridge.h"
+#include "fseq/FSEQFile.h"
 #include "log.h"
 #include "PixelOverlay.h"
 #include "Sequence.h"
@@ -348,6 +357,8 @@ void Bridge_Initialize(int &eSock, int &dSock)
 
 void Bridge_Shutdown(void)
 {
+    Bridge_StopRecording();
+
     close(bridgeSock);
     close(ddpSock);
     bridgeSock = -1;
@@ -632,3 +643,250 @@ void InputUniversesPrint()
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Recording of the bridged data.  The output thread only copies the used
+// channel ranges of each frame into a pooled buffer, the compression and
+// file writes are done on the recording thread.
+
+class BridgeRecordFrame {
+  public:
+    BridgeRecordFrame(uint32_t size) : frame(0), data(size) {}
+
+    uint32_t             frame;
+    std::vector<uint8_t> data;
+};
+
+static std::mutex                  recordControlLock;
+static std::mutex                  recordLock;
+static std::condition_variable     recordSignal;
+static std::thread                *recordThread = nullptr;
+static std::atomic_bool            recordRunning(false);
+static std::list<BridgeRecordFrame*> recordQueue;
+static std::list<BridgeRecordFrame*> recordFree;
+static std::vector<std::pair<uint32_t, uint32_t>> recordRanges;
+static std::string                 recordName;
+static long long                   recordStartTime = 0;
+static int                         recordStepTime = 50;
+static uint32_t                    recordMaxFrames = 0;
+static uint32_t                    recordNextFrame = 0;
+static uint32_t                    recordFramesWritten = 0;
+static uint32_t                    recordFramesDropped = 0;
+
+static void Bridge_RecordLoop(FSEQFile *file, std::string tmpName, std::string fileName)
+{
+    uint32_t maxChannel = recordRanges.back().first + recordRanges.back().second;
+    std::vector<uint8_t> frameData(maxChannel);
+    uint32_t written = 0;
+
+    std::unique_lock<std::mutex> lock(recordLock);
+    while (recordRunning || !recordQueue.empty()) {
+        if (recordQueue.empty()) {
+            recordSignal.wait(lock);
+            continue;
+        }
+        BridgeRecordFrame *f = recordQueue.front();
+        recordQueue.pop_front();
+        lock.unlock();
+
+        // frames that were dropped or skipped repeat the previous frame
+        while (written < f->frame) {
+            file->addFrame(written++, &frameData[0]);
+        }
+        uint32_t offset = 0;
+        for (auto &r : recordRanges) {
+            memcpy(&frameData[r.first], &f->data[offset], r.second);
+            offset += r.second;
+        }
+        file->addFrame(written++, &frameData[0]);
+
+        lock.lock();
+        recordFree.push_back(f);
+        recordFramesWritten = written;
+    }
+    lock.unlock();
+
+    file->setNumFrames(written);
+    file->finalize();
+    delete file;
+
+    if (rename(tmpName.c_str(), fileName.c_str())) {
+        LogErr(VB_E131BRIDGE, "Could not rename %s to %s: %s\n",
+            tmpName.c_str(), fileName.c_str(), strerror(errno));
+        unlink(tmpName.c_str());
+        return;
+    }
+    LogInfo(VB_E131BRIDGE, "Recorded %d frames to %s\n", written, fileName.c_str());
+}
+
+// recordControlLock must be held by the caller
+static void Bridge_StopRecordThread(void)
+{
+    std::unique_lock<std::mutex> lock(recordLock);
+    recordRunning = false;
+    lock.unlock();
+    recordSignal.notify_all();
+
+    if (!recordThread)
+        return;
+
+    recordThread->join();
+    delete recordThread;
+    recordThread = nullptr;
+
+    if (recordFramesDropped)
+        LogWarn(VB_E131BRIDGE, "Dropped %d frames while recording %s\n",
+            recordFramesDropped, recordName.c_str());
+
+    lock.lock();
+    for (auto f : recordFree)
+        delete f;
+    recordFree.clear();
+}
+
+bool Bridge_StartRecording(const std::string &name)
+{
+    std::unique_lock<std::mutex> controlLock(recordControlLock);
+
+    if (getFPPmode() != BRIDGE_MODE) {
+        LogErr(VB_E131BRIDGE, "Can not record bridge data when not in bridge mode\n");
+        return false;
+    }
+    if (name.empty() || (name.find('/') != std::string::npos)) {
+        LogErr(VB_E131BRIDGE, "Invalid bridge recording name '%s'\n", name.c_str());
+        return false;
+    }
+
+    Bridge_StopRecordThread();
+
+    recordName = name;
+    if (!boost::ends_with(recordName, ".fseq"))
+        recordName += ".fseq";
+    std::string fileName = std::string(getSequenceDirectory()) + "/" + recordName;
+    std::string tmpName = fileName + ".tmp";
+
+    // Record what is being output, or everything we receive if there
+    // are no outputs configured
+    recordRanges.clear();
+    if (GetChannelOutputCount()) {
+        recordRanges = GetOutputRanges();
+    } else {
+        for (int i = 0; i < InputUniverseCount; i++) {
+            if (InputUniverses[i].active && (InputUniverses[i].size > 0))
+                recordRanges.push_back(std::pair<uint32_t, uint32_t>(
+                    InputUniverses[i].startAddress - 1, InputUniverses[i].size));
+        }
+        MergeChannelRanges(recordRanges);
+    }
+    if (recordRanges.empty()) {
+        LogErr(VB_E131BRIDGE, "No channels to record to %s\n", recordName.c_str());
+        return false;
+    }
+
+    uint32_t frameSize = 0;
+    for (auto &r : recordRanges)
+        frameSize += r.second;
+
+    recordStepTime = getSettingInt("E131BridgingInterval");
+    if (!recordStepTime)
+        recordStepTime = 50;
+
+    // The block index in the header is sized up front, so the length
+    // of a recording is limited
+    int maxMinutes = getSettingInt("BridgeRecordMaxMinutes");
+    if (maxMinutes <= 0)
+        maxMinutes = 60;
+    recordMaxFrames = maxMinutes * 60000 / recordStepTime;
+
+    V2FSEQFile *file = (V2FSEQFile*)FSEQFile::createFSEQFile(tmpName, 2,
+        FSEQFile::CompressionType::zstd, -1);
+    if (!file) {
+        LogErr(VB_E131BRIDGE, "Could not create %s\n", tmpName.c_str());
+        return false;
+    }
+    file->m_sparseRanges = recordRanges;
+    file->setChannelCount(recordRanges.back().first + recordRanges.back().second);
+    file->setNumFrames(recordMaxFrames);
+    file->setStepTime(recordStepTime);
+    file->writeHeader();
+
+    LogInfo(VB_E131BRIDGE, "Recording %d channels in %d ranges to %s\n",
+        frameSize, (int)recordRanges.size(), recordName.c_str());
+
+    std::unique_lock<std::mutex> lock(recordLock);
+    for (int i = 0; i < BRIDGE_RECORD_QUEUE_FRAMES; i++)
+        recordFree.push_back(new BridgeRecordFrame(frameSize));
+
+    recordNextFrame = 0;
+    recordFramesWritten = 0;
+    recordFramesDropped = 0;
+    recordStartTime = GetMonotonicTime();
+    recordRunning = true;
+    recordThread = new std::thread(Bridge_RecordLoop, file, tmpName, fileName);
+
+    return true;
+}
+
+void Bridge_StopRecording(void)
+{
+    std::unique_lock<std::mutex> controlLock(recordControlLock);
+
+    Bridge_StopRecordThread();
+}
+
+// Called from ProcessSequenceData before the outputs prepare each frame
+void Bridge_RecordFrame(const char *data)
+{
+    if (!recordRunning)
+        return;
+
+    uint32_t frame = (GetMonotonicTime() - recordStartTime) / (recordStepTime * 1000);
+
+    std::unique_lock<std::mutex> lock(recordLock);
+    if (!recordRunning || (frame < recordNextFrame))
+        return;
+
+    if (frame >= recordMaxFrames) {
+        LogWarn(VB_E131BRIDGE, "Maximum length reached for recording %s\n", recordName.c_str());
+        recordRunning = false;
+        lock.unlock();
+        recordSignal.notify_all();
+        return;
+    }
+
+    recordNextFrame = frame + 1;
+    if (recordFree.empty()) {
+        // the recording thread is behind, it will repeat the previous frame
+        recordFramesDropped++;
+        return;
+    }
+
+    BridgeRecordFrame *f = recordFree.front();
+    recordFree.pop_front();
+
+    f->frame = frame;
+    uint32_t offset = 0;
+    for (auto &r : recordRanges) {
+        memcpy(&f->data[offset], data + r.first, r.second);
+        offset += r.second;
+    }
+
+    recordQueue.push_back(f);
+    lock.unlock();
+    recordSignal.notify_one();
+}
+
+Json::Value Bridge_GetRecordingStatus(void)
+{
+    Json::Value result;
+
+    std::unique_lock<std::mutex> lock(recordLock);
+    result["recording"] = (bool)recordRunning;
+    result["name"] = recordName;
+    result["stepTime"] = recordStepTime;
+    result["maxFrames"] = recordMaxFrames;
+    result["framesWritten"] = recordFramesWritten;
+    result["framesDropped"] = recordFramesDropped;
+    result["framesQueued"] = (int)recordQueue.size();
+
+    return result;
+}
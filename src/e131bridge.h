@@ -26,6 +26,8 @@
 #ifndef _E131_BRIDGE_H
 #define _E131_BRIDGE_H
 
+#include <string>
+
 #include "e131defs.h"
 
 void Bridge_Initialize(int &e131Socket, int &ddpSocket);
@@ -36,4 +38,12 @@ void Bridge_Shutdown(void);
 void  ResetBytesReceived();
 Json::Value GetE131UniverseBytesReceived();
 
+// Recording of the bridged data into a sequence file
+#define BRIDGE_RECORD_QUEUE_FRAMES 64
+
+bool Bridge_StartRecording(const std::string &name);
+void Bridge_StopRecording(void);
+void Bridge_RecordFrame(const char *data);
+Json::Value Bridge_GetRecordingStatus(void);
+
 #endif
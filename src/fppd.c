@@ -40,11 +40,13 @@
 #include "mediaoutput.h"
 #include "mqtt.h"
 #include "PixelOverlay.h"
+#include "PlaybackThreads.h"
 #include "Playlist.h"
 #include "playlist/Playlist.h"
 #include "Plugins.h"
 #include "Scheduler.h"
 #include "Sequence.h"
+#include "SequenceLayer.h"
 #include "settings.h"
 
 #include <errno.h>
@@ -487,16 +489,21 @@ int main(int argc, char *argv[])
     }
 
 
+	InitPlaybackThreads();
+
 	if (getFPPmode() != BRIDGE_MODE)
 	{
 		InitMediaOutput();
 	}
 
 	InitializeChannelOutputs();
+	InitOutputPipeline();
 	sequence->SendBlankingData();
 
 	InitEffects();
 	InitializeChannelDataMemoryMap();
+
+	LockPlaybackMemory();
     
     WriteRuntimeInfoFile(multiSync->GetSystems(true, false));
 
@@ -511,9 +518,11 @@ int main(int argc, char *argv[])
 	{
 		CloseChannelDataMemoryMap();
 		CloseEffects();
+		StopAllSequenceLayers();
 	}
 
 	CloseChannelOutputs();
+	CloseOutputPipeline();
 
 	delete multiSync;
 	delete channelTester;
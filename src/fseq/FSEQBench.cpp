@@ -0,0 +1,408 @@
+
+#include <getopt.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+#include "fppversion.h"
+#include "log.h"
+
+#include "FSEQFile.h"
+
+void usage(char *appname) {
+    printf("Usage: %s [OPTIONS] FileName.fseq [FileName2.fseq ...]\n", appname);
+    printf("\n");
+    printf("  Benchmarks reading frames from FSEQ files the way a player does\n");
+    printf("  (getFrame + readFrame) and reports throughput and frame latency.\n");
+    printf("\n");
+    printf("  Options:\n");
+    printf("   -V                - Print version information\n");
+    printf("   -v                - verbose\n");
+    printf("   -r (#-# | #+#)    - Channel Range to read.  Use - to separate start/end channel\n");
+    printf("                            Use + to separate start channel + num channels\n");
+    printf("                            Can be used multiple times, default is all channels\n");
+    printf("   -p (s|r|b)        - Access patterns to run: s - sequential, r - random seek,\n");
+    printf("                            b - reverse step.  Default is srb\n");
+    printf("   -n #              - Number of frames to read per pattern, default is all\n");
+    printf("   -R                - Pace sequential reads at the sequence step time like\n");
+    printf("                            a live show instead of reading as fast as possible\n");
+    printf("   -b                - Use fillFrame into a reused buffer instead of getFrame\n");
+    printf("   -c #              - Size of the compressed block cache in MB, shared by\n");
+    printf("                            all the patterns and files\n");
+    printf("   -t DIR            - Transcode the first file into v1 and each v2 compression\n");
+    printf("                            type in DIR and benchmark all of them\n");
+    printf("   -s #              - Channel stripes for -t compressed files\n");
+    printf("   -x                - XOR frames for -t compressed files\n");
+    printf("   -e                - Allow more than 255 compression blocks for -t compressed files\n");
+    printf("   -h                - This help output\n");
+}
+static bool verbose = false;
+static std::vector<std::pair<uint32_t, uint32_t>> ranges;
+static std::string patterns = "srb";
+static uint32_t maxFrames = 0;
+static bool realtime = false;
+static bool useFillFrame = false;
+static const char *transcodeDir = nullptr;
+static int channelStripes = 0;
+static bool xorFrames = false;
+static bool extendedBlockIndex = false;
+static int cacheMB = 0;
+
+int parseArguments(int argc, char **argv) {
+    int   c;
+
+    while (1) {
+        int option_index = 0;
+        static struct option long_options[] = {
+            {"help",           no_argument,          0, 'h'},
+            {0,                0,                    0, 0}
+        };
+
+        c = getopt_long(argc, argv, "r:p:n:t:s:c:hVvRbxe", long_options, &option_index);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 'r': {
+                    char *end = optarg;
+                    int startc = strtol(optarg, &end, 10);
+                    int r = *end == '-';
+                    end++;
+                    int endc = strtol(end, &end, 10);
+                    if (r) {
+                        ranges.push_back(std::pair<uint32_t, uint32_t>(startc, endc-startc+1));
+                    } else {
+                        ranges.push_back(std::pair<uint32_t, uint32_t>(startc, endc));
+                    }
+                }
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'p':
+                patterns = optarg;
+                break;
+            case 'n':
+                maxFrames = strtol(optarg, NULL, 10);
+                break;
+            case 'R':
+                realtime = true;
+                break;
+            case 'b':
+                useFillFrame = true;
+                break;
+            case 't':
+                transcodeDir = optarg;
+                break;
+            case 's':
+                channelStripes = strtol(optarg, NULL, 10);
+                break;
+            case 'x':
+                xorFrames = true;
+                break;
+            case 'e':
+                extendedBlockIndex = true;
+                break;
+            case 'c':
+                cacheMB = strtol(optarg, NULL, 10);
+                break;
+            case 'V':
+                printVersionInfo();
+                exit(0);
+            case 'h':
+                usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    return optind;
+}
+
+static uint64_t nowNS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+static double toMS(uint64_t ns) {
+    return ns / 1000000.0;
+}
+
+static std::string describeFile(FSEQFile *f) {
+    char buf[64];
+    if (f->getVersionMajor() == 1) {
+        snprintf(buf, sizeof(buf), "v1");
+        return buf;
+    }
+    V2FSEQFile *v2 = (V2FSEQFile*)f;
+    const char *ct = "none";
+    switch (v2->m_compressionType) {
+        case FSEQFile::CompressionType::zstd: ct = "zstd"; break;
+        case FSEQFile::CompressionType::zlib: ct = "zlib"; break;
+        case FSEQFile::CompressionType::lz4: ct = "lz4"; break;
+        default: break;
+    }
+    snprintf(buf, sizeof(buf), "v%d.%d %s, %d blocks%s%s", f->getVersionMajor(), f->getVersionMinor(),
+             ct, (int)v2->m_frameOffsets.size(),
+             v2->m_channelStripes > 1 ? ", striped" : "",
+             v2->m_xorFrames ? ", xor" : "");
+    return buf;
+}
+
+// the frames that start a compression block, reading them usually means
+// waiting on a decompress
+static std::set<uint32_t> getBlockStarts(FSEQFile *f) {
+    std::set<uint32_t> starts;
+    if (f->getVersionMajor() == 2) {
+        V2FSEQFile *v2 = (V2FSEQFile*)f;
+        if (v2->m_compressionType != FSEQFile::CompressionType::none) {
+            for (auto &a : v2->m_frameOffsets) {
+                starts.insert(a.first);
+            }
+        }
+    }
+    return starts;
+}
+
+static void printStats(const char *name, std::vector<uint64_t> &times) {
+    if (times.empty()) {
+        return;
+    }
+    uint64_t total = 0;
+    for (auto t : times) {
+        total += t;
+    }
+    std::vector<uint64_t> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    printf("      %-12s %6d frames  avg %7.3fms  p50 %7.3fms  p99 %7.3fms  max %7.3fms\n", name,
+           (int)sorted.size(), toMS(total / sorted.size()), toMS(sorted[sorted.size() / 2]),
+           toMS(sorted[(sorted.size() * 99) / 100]), toMS(sorted.back()));
+}
+
+static void runPattern(const std::string &fn, char pattern) {
+    uint64_t start = nowNS();
+    FSEQFile *f = FSEQFile::openFSEQFile(fn);
+    if (f == nullptr) {
+        return;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> rng = ranges;
+    if (rng.empty()) {
+        rng.push_back(std::pair<uint32_t, uint32_t>(0, f->getMaxChannel()));
+    }
+    f->prepareRead(rng);
+    uint64_t openTime = nowNS() - start;
+
+    uint32_t numFrames = f->getNumFrames();
+    if (numFrames == 0) {
+        printf("   %s has no frames\n", fn.c_str());
+        delete f;
+        return;
+    }
+    uint32_t count = maxFrames ? std::min(maxFrames, numFrames) : numFrames;
+    std::vector<uint32_t> frames;
+    frames.reserve(count);
+    const char *name = "sequential";
+    if (pattern == 'r') {
+        name = "random seek";
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<uint32_t> dist(0, numFrames - 1);
+        for (uint32_t x = 0; x < count; x++) {
+            frames.push_back(dist(gen));
+        }
+    } else if (pattern == 'b') {
+        name = "reverse";
+        for (uint32_t x = 0; x < count; x++) {
+            frames.push_back(numFrames - 1 - x);
+        }
+    } else {
+        for (uint32_t x = 0; x < count; x++) {
+            frames.push_back(x);
+        }
+    }
+
+    uint32_t maxChannel = f->getMaxChannel();
+    for (auto &r : rng) {
+        maxChannel = std::max(maxChannel, r.first + r.second);
+    }
+    std::vector<uint8_t> data(maxChannel + 1);
+    std::vector<uint8_t> fillBuffer(f->getDataBlockSize() + 1);
+    FSEQFile::BufferFrameData fillData(&fillBuffer[0]);
+
+    std::set<uint32_t> blockStarts = getBlockStarts(f);
+    std::vector<uint64_t> times;
+    std::vector<uint64_t> blockTimes;
+    std::vector<uint64_t> otherTimes;
+    times.reserve(count);
+    uint64_t stepNS = (uint64_t)f->getStepTime() * 1000000;
+    uint64_t nextFrame = nowNS();
+    uint64_t totalStart = nowNS();
+    uint64_t readTime = 0;
+    for (auto frame : frames) {
+        if (realtime && pattern == 's') {
+            uint64_t now = nowNS();
+            if (now < nextFrame) {
+                usleep((nextFrame - now) / 1000);
+            }
+            nextFrame += stepNS;
+        }
+        uint64_t fs = nowNS();
+        if (useFillFrame) {
+            f->fillFrame(frame, &fillData);
+        } else {
+            FSEQFile::FrameData *fd = f->getFrame(frame);
+            if (fd) {
+                fd->readFrame(&data[0]);
+                delete fd;
+            }
+        }
+        uint64_t t = nowNS() - fs;
+        readTime += t;
+        times.push_back(t);
+        if (!blockStarts.empty()) {
+            if (blockStarts.find(frame) != blockStarts.end()) {
+                blockTimes.push_back(t);
+            } else {
+                otherTimes.push_back(t);
+            }
+        }
+    }
+    uint64_t totalTime = nowNS() - totalStart;
+    uint32_t blockSize = f->getDataBlockSize();
+    delete f;
+
+    double secs = readTime / 1000000000.0;
+    double mb = (double)blockSize * count / (1024.0 * 1024.0);
+    if (secs <= 0) {
+        secs = 0.000001;
+    }
+    printf("   %s: open+prepareRead %.3fms, %.1f frames/s, %.1f MB/s", name, toMS(openTime),
+           count / secs, mb / secs);
+    if (realtime && pattern == 's') {
+        printf(", %.1fs wall", totalTime / 1000000000.0);
+    }
+    printf("\n");
+    printStats("all", times);
+    printStats("block start", blockTimes);
+    printStats("other", otherTimes);
+}
+
+static void benchmarkFile(const std::string &fn) {
+    FSEQFile *f = FSEQFile::openFSEQFile(fn);
+    if (f == nullptr) {
+        return;
+    }
+    FILE *file = fopen(fn.c_str(), "rb");
+    long size = 0;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        fclose(file);
+    }
+    printf("%s: %s, %d channels, %d frames @ %dms, %.2f MB\n", fn.c_str(), describeFile(f).c_str(),
+           f->getChannelCount(), f->getNumFrames(), f->getStepTime(), size / (1024.0 * 1024.0));
+    delete f;
+
+    for (auto p : patterns) {
+        runPattern(fn, p);
+    }
+}
+
+static bool transcode(const std::string &src, const std::string &dst, int version, FSEQFile::CompressionType ct) {
+    FSEQFile *s = FSEQFile::openFSEQFile(src);
+    if (s == nullptr) {
+        return false;
+    }
+    if (s->getNumFrames() == 0) {
+        printf("%s has no frames to transcode\n", src.c_str());
+        delete s;
+        return false;
+    }
+    FSEQFile *d = FSEQFile::createFSEQFile(dst, version, ct, -1);
+    if (d == nullptr) {
+        delete s;
+        return false;
+    }
+    if (version == 2) {
+        ((V2FSEQFile*)d)->m_channelStripes = channelStripes;
+        ((V2FSEQFile*)d)->m_xorFrames = xorFrames;
+        ((V2FSEQFile*)d)->m_extendedBlockIndex = extendedBlockIndex;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> rng;
+    rng.push_back(std::pair<uint32_t, uint32_t>(0, s->getMaxChannel()));
+    s->prepareRead(rng);
+    d->initializeFromFSEQ(*s);
+    d->writeHeader();
+
+    std::vector<uint8_t> data(s->getMaxChannel() + 1);
+    for (uint32_t x = 0; x < s->getNumFrames(); x++) {
+        FSEQFile::FrameData *fdata = s->getFrame(x);
+        if (fdata == nullptr) {
+            printf("Could not read frame %d of %s\n", x, src.c_str());
+            delete d;
+            delete s;
+            unlink(dst.c_str());
+            return false;
+        }
+        fdata->readFrame(&data[0]);
+        delete fdata;
+        d->addFrame(x, &data[0]);
+    }
+    d->finalize();
+    delete d;
+    delete s;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int idx = parseArguments(argc, argv);
+    if (verbose) {
+        SetLogLevel("debug");
+    }
+    if (idx >= argc) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    FSEQFile::setBlockCacheSize((uint64_t)cacheMB * 1024 * 1024);
+    std::vector<std::string> files;
+    std::vector<std::string> tempFiles;
+    for (int x = idx; x < argc; x++) {
+        files.push_back(argv[x]);
+    }
+    if (transcodeDir) {
+        static const struct {
+            const char *name;
+            int version;
+            FSEQFile::CompressionType ct;
+        } formats[] = {
+            { "v1", 1, FSEQFile::CompressionType::none },
+            { "none", 2, FSEQFile::CompressionType::none },
+            { "zstd", 2, FSEQFile::CompressionType::zstd },
+            { "zlib", 2, FSEQFile::CompressionType::zlib },
+            { "lz4", 2, FSEQFile::CompressionType::lz4 },
+        };
+        for (auto &fmt : formats) {
+            std::string dst = std::string(transcodeDir) + "/fseqbench_" + fmt.name + ".fseq";
+            uint64_t start = nowNS();
+            if (transcode(files[0], dst, fmt.version, fmt.ct)) {
+                printf("Transcoded %s to %s in %.1fms\n", files[0].c_str(), fmt.name, toMS(nowNS() - start));
+                tempFiles.push_back(dst);
+            }
+        }
+        files.insert(files.end(), tempFiles.begin(), tempFiles.end());
+    }
+    for (auto &fn : files) {
+        benchmarkFile(fn);
+    }
+    for (auto &fn : tempFiles) {
+        unlink(fn.c_str());
+    }
+    return 0;
+}
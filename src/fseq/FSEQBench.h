@@ -0,0 +1,3 @@
+#ifndef __FSEQBench_H
+
+#endif
@@ -6,6 +6,12 @@
 #include <vector>
 #include <cstring>
 #include <memory>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <list>
+#include <unordered_map>
 
 #include <stdio.h>
 #include <inttypes.h>
@@ -38,9 +44,11 @@ int gettimeofday(struct timeval * tp, struct timezone * tzp)
 #define ftello _ftelli64
 #define fseeko _fseeki64
 #define NO_ZLIB
+#define NO_LZ4
 
 #else
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -76,6 +84,10 @@ template<typename... Args> static void LogDebug(int i, const char *fmt, Args...
 #ifndef NO_ZLIB
 #include <zlib.h>
 #endif
+#ifndef NO_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
 
 using FrameData = FSEQFile::FrameData;
 
@@ -251,7 +263,8 @@ std::string FSEQFile::getMediaFilename() const {
 }
 
 FSEQFile::FSEQFile(const std::string &fn)
-    : m_filename(fn),
+    : m_dataBlockSize(0),
+    m_filename(fn),
     m_seqNumFrames(0),
     m_seqChannelCount(0),
     m_seqStepTime(50),
@@ -260,6 +273,8 @@ FSEQFile::FSEQFile(const std::string &fn)
     m_seqFileSize(0),
     m_seqVersionMajor(1),
     m_seqVersionMinor(0),
+    m_mappedReadAheadStart(0),
+    m_mappedReadAheadEnd(0),
     m_memoryBuffer(),
     m_seqChanDataOffset(0),
     m_memoryBufferPos(0)
@@ -297,9 +312,12 @@ void FSEQFile::initializeFromFSEQ(const FSEQFile& fseq) {
 
 
 FSEQFile::FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header)
-    : m_filename(fn),
+    : m_dataBlockSize(0),
+    m_filename(fn),
     m_seqFile(file),
     m_uniqueId(0),
+    m_mappedReadAheadStart(0),
+    m_mappedReadAheadEnd(0),
     m_memoryBuffer(),
     m_memoryBufferPos(0)
 {
@@ -307,6 +325,15 @@ FSEQFile::FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t>
     m_seqFileSize = ftello(m_seqFile);
     fseeko(m_seqFile, 0L, SEEK_SET);
 
+    //key cached blocks on the file that is actually open so a file replaced
+    //within the same second (or after the name was looked up) isn't mixed up
+    struct stat st;
+    if (fstat(fileno(m_seqFile), &st) == 0) {
+        m_cacheKey = fn + ":" + std::to_string((uint64_t)st.st_ino)
+            + ":" + std::to_string((uint64_t)st.st_mtim.tv_sec) + "." + std::to_string((uint64_t)st.st_mtim.tv_nsec)
+            + ":" + std::to_string((uint64_t)st.st_size);
+    }
+
     if (header[0] == 'E') {
         m_seqChanDataOffset = 20;
         m_seqVersionMinor = 0;
@@ -329,6 +356,147 @@ FSEQFile::~FSEQFile() {
     }
 }
 
+//The mapping is reference counted so any FrameData still holding a view
+//into it keeps it valid after the FSEQFile itself has been deleted
+class FSEQFile::MemoryMap {
+public:
+    MemoryMap(uint8_t *d, uint64_t s) : m_data(d), m_size(s) {}
+    ~MemoryMap() {
+#ifndef _MSC_VER
+        munmap(m_data, m_size);
+#endif
+    }
+
+    uint8_t *m_data;
+    uint64_t m_size;
+};
+
+//copy len bytes at start of a mapped frame of size bytes, the part of the
+//range past the end of the frame is zeroed like a short read
+static void copyMappedRange(uint8_t *dest, const uint8_t *frame, uint32_t size,
+                            uint32_t start, uint32_t len) {
+    uint32_t avail = (start < size) ? std::min(len, size - start) : 0;
+    if (avail) {
+        memcpy(dest, &frame[start], avail);
+    }
+    if (avail < len) {
+        memset(&dest[avail], 0, len - avail);
+    }
+}
+
+class MappedFrameData : public FSEQFile::FrameData {
+public:
+    MappedFrameData(uint32_t frame,
+                    const std::shared_ptr<FSEQFile::MemoryMap> &map,
+                    const FSEQFile::RangeList &ranges,
+                    const uint8_t *data, uint32_t size, bool packed)
+    : FrameData(frame), m_map(map), m_ranges(ranges), m_data(data), m_size(size), m_packed(packed) {
+    }
+    virtual ~MappedFrameData() {
+    }
+
+    virtual void readFrame(uint8_t *data) override {
+        uint32_t offset = 0;
+        for (auto &rng : *m_ranges) {
+            uint32_t start = m_packed ? offset : rng.first;
+            copyMappedRange(&data[rng.first], m_data, m_size, start, rng.second);
+            offset += rng.second;
+        }
+    }
+
+    std::shared_ptr<FSEQFile::MemoryMap> m_map;
+    FSEQFile::RangeList m_ranges;
+    const uint8_t *m_data;
+    uint32_t m_size;
+    bool m_packed;
+};
+
+bool FSEQFile::mapFile() {
+#ifdef _MSC_VER
+    return false;
+#else
+    if (m_memoryMap) {
+        return true;
+    }
+    if (m_seqFile == nullptr || m_seqFileSize == 0) {
+        return false;
+    }
+#if SIZE_MAX < UINT64_MAX
+    //32 bit builds can't map files over 4GB
+    if (m_seqFileSize > SIZE_MAX) {
+        return false;
+    }
+#endif
+    void *data = mmap(nullptr, m_seqFileSize, PROT_READ, MAP_SHARED, fileno(m_seqFile), 0);
+    if (data == MAP_FAILED) {
+        LogErr(VB_SEQUENCE, "Could not memory map sequence file %s, using normal reads\n", m_filename.c_str());
+        return false;
+    }
+    m_memoryMap = std::make_shared<MemoryMap>((uint8_t*)data, m_seqFileSize);
+    m_mappedReadAheadStart = 0;
+    m_mappedReadAheadEnd = 0;
+    LogDebug(VB_SEQUENCE, "Memory mapped sequence file %s\n", m_filename.c_str());
+    return true;
+#endif
+}
+
+void FSEQFile::setReadRanges(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) {
+    m_readRanges = std::make_shared<const std::vector<std::pair<uint32_t, uint32_t>>>(ranges);
+}
+
+bool FSEQFile::mappedReadAhead(uint64_t offset, uint32_t size) {
+    //keep the kernel reading ahead of us.  Only re-advise once we get into
+    //the back half of the window (or jump outside of it) so we don't end up
+    //with a syscall for every frame
+    //touching a mapped page past the end of a file that was truncated
+    //while playing is a SIGBUS rather than a short read, so stop using
+    //the mapping if the file got smaller
+    struct stat st;
+    if (fstat(fileno(m_seqFile), &st) || ((uint64_t)st.st_size < m_memoryMap->m_size)) {
+        LogWarn(VB_SEQUENCE, "Sequence file %s was truncated, no longer using the memory map\n", m_filename.c_str());
+        m_memoryMap.reset();
+        return false;
+    }
+
+    uint64_t window = std::max((uint64_t)size * 10, (uint64_t)(1024 * 1024));
+    if (offset < m_mappedReadAheadStart || (offset + size + window / 2) > m_mappedReadAheadEnd) {
+        preload(offset, window);
+        m_mappedReadAheadStart = offset;
+        m_mappedReadAheadEnd = offset + window;
+    }
+    return true;
+}
+
+FrameData *FSEQFile::getMappedFrame(uint32_t frame, uint64_t offset, uint32_t size, bool packed) {
+    if (!m_memoryMap || !m_readRanges || (offset + size) > m_memoryMap->m_size) {
+        return nullptr;
+    }
+    if (!mappedReadAhead(offset, size)) {
+        return nullptr;
+    }
+    return new MappedFrameData(frame, m_memoryMap, m_readRanges, &m_memoryMap->m_data[offset], size, packed);
+}
+
+bool FSEQFile::readMappedFrameData(uint64_t offset, uint32_t size, bool packed, uint8_t *data) {
+    if (!m_memoryMap || (offset + size) > m_memoryMap->m_size) {
+        return false;
+    }
+    if (!mappedReadAhead(offset, size)) {
+        return false;
+    }
+    const uint8_t *fdata = &m_memoryMap->m_data[offset];
+    if (packed) {
+        memcpy(data, fdata, m_dataBlockSize);
+    } else {
+        uint32_t sz = 0;
+        for (auto &rng : m_rangesToRead) {
+            copyMappedRange(&data[sz], fdata, size, rng.first, rng.second);
+            sz += rng.second;
+        }
+    }
+    return true;
+}
+
 int FSEQFile::seek(uint64_t location, int origin) {
     if (m_seqFile) {
         return fseeko(m_seqFile, location, origin);
@@ -365,7 +533,148 @@ uint64_t FSEQFile::read(void *ptr, uint64_t size) {
     return fread(ptr, 1, size, m_seqFile);
 }
 
+uint64_t FSEQFile::readAt(void *ptr, uint64_t size, uint64_t pos) {
+#ifdef _MSC_VER
+    seek(pos, SEEK_SET);
+    return read(ptr, size);
+#else
+    uint8_t *data = (uint8_t*)ptr;
+    uint64_t total = 0;
+    while (total < size) {
+        ssize_t r = pread(fileno(m_seqFile), &data[total], size - total, pos + total);
+        if (r <= 0) {
+            break;
+        }
+        total += r;
+    }
+    return total;
+#endif
+}
+
+// LRU cache of compressed blocks keyed by file path, mtime and size plus
+// the block position so sequences that are played over and over don't need
+// to be read from storage each time.
+class FSEQBlockCache {
+public:
+    FSEQBlockCache() : m_maxSize(0), m_size(0), m_hits(0), m_misses(0) {}
+
+    void setMaxSize(uint64_t s) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (s != m_maxSize) {
+            LogDebug(VB_SEQUENCE, "FSEQ block cache size set to %" PRIu64 " bytes\n", s);
+        }
+        m_maxSize = s;
+        evict(0);
+    }
+    bool enabled() const { return m_maxSize > 0; }
+
+    bool contains(const std::string &key) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        return m_index.find(key) != m_index.end();
+    }
+    bool get(const std::string &key, void *ptr, uint64_t size) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        auto i = m_index.find(key);
+        if (i == m_index.end() || i->second->data.size() != size) {
+            m_misses++;
+            return false;
+        }
+        m_hits++;
+        //move to the front as the most recently used
+        m_entries.splice(m_entries.begin(), m_entries, i->second);
+        memcpy(ptr, &i->second->data[0], size);
+        return true;
+    }
+    void put(const std::string &key, const void *ptr, uint64_t size) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (size == 0 || size > m_maxSize || m_index.find(key) != m_index.end()) {
+            return;
+        }
+        evict(size);
+        m_entries.emplace_front();
+        Entry &e = m_entries.front();
+        e.key = key;
+        e.data.assign((const uint8_t*)ptr, (const uint8_t*)ptr + size);
+        m_index[key] = m_entries.begin();
+        m_size += size;
+    }
+
+private:
+    //drop the least recently used blocks until there is room for size more bytes
+    void evict(uint64_t size) {
+        while (!m_entries.empty() && (m_size + size) > m_maxSize) {
+            Entry &e = m_entries.back();
+            m_size -= e.data.size();
+            m_index.erase(e.key);
+            m_entries.pop_back();
+        }
+        if (m_entries.empty() && (m_hits || m_misses)) {
+            LogDebug(VB_SEQUENCE, "FSEQ block cache emptied, %" PRIu64 " hits, %" PRIu64 " misses\n", m_hits, m_misses);
+            m_hits = m_misses = 0;
+        }
+    }
+
+    class Entry {
+    public:
+        std::string key;
+        std::vector<uint8_t> data;
+    };
+    std::mutex m_lock;
+    std::list<Entry> m_entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+    uint64_t m_maxSize;
+    uint64_t m_size;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+static FSEQBlockCache BLOCK_CACHE;
+
+void FSEQFile::setBlockCacheSize(uint64_t maxSize) {
+    BLOCK_CACHE.setMaxSize(maxSize);
+}
+
+static std::string blockCacheKey(const std::string &fileKey, uint64_t pos, uint64_t size) {
+    return fileKey + ":" + std::to_string(pos) + ":" + std::to_string(size);
+}
+
+uint64_t FSEQFile::readCachedAt(void *ptr, uint64_t size, uint64_t pos) {
+    if (!BLOCK_CACHE.enabled() || m_cacheKey.empty()) {
+        return readAt(ptr, size, pos);
+    }
+    std::string key = blockCacheKey(m_cacheKey, pos, size);
+    if (BLOCK_CACHE.get(key, ptr, size)) {
+        return size;
+    }
+    uint64_t r = readAt(ptr, size, pos);
+    if (r == size) {
+        BLOCK_CACHE.put(key, ptr, size);
+    }
+    return r;
+}
+
+bool FSEQFile::isCached(uint64_t pos, uint64_t size) {
+    if (!BLOCK_CACHE.enabled() || m_cacheKey.empty()) {
+        return false;
+    }
+    return BLOCK_CACHE.contains(blockCacheKey(m_cacheKey, pos, size));
+}
+
 void FSEQFile::preload(uint64_t pos, uint64_t size) {
+#ifndef _MSC_VER
+    if (m_memoryMap) {
+        if (pos >= m_memoryMap->m_size) {
+            return;
+        }
+        if ((pos + size) > m_memoryMap->m_size) {
+            size = m_memoryMap->m_size - pos;
+        }
+        //madvise needs a page aligned address
+        static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+        uint64_t start = pos - (pos % pageSize);
+        madvise(&m_memoryMap->m_data[start], size + pos - start, MADV_WILLNEED);
+        return;
+    }
+#endif
 #ifndef PLATFORM_UNKNOWN
     posix_fadvise(fileno(m_seqFile), pos, size, POSIX_FADV_WILLNEED);
 #endif
@@ -393,7 +702,7 @@ void FSEQFile::finalize() {
 
 
 V1FSEQFile::V1FSEQFile(const std::string &fn)
-  : FSEQFile(fn), m_dataBlockSize(0)
+  : FSEQFile(fn)
 {
 }
 
@@ -485,42 +794,57 @@ V1FSEQFile::~V1FSEQFile() {
 
 }
 
-class UncompressedFrameData : public FSEQFile::FrameData {
+void FSEQFile::BufferFrameData::readFrame(uint8_t *data) {
+    uint32_t offset = 0;
+    for (auto &rng : *m_ranges) {
+        uint32_t toRead = rng.second;
+        memcpy(&data[rng.first], &m_data[offset], toRead);
+        offset += toRead;
+    }
+}
+
+class UncompressedFrameData : public FSEQFile::BufferFrameData {
 public:
     UncompressedFrameData(uint32_t frame,
                           uint32_t sz,
                           const std::vector<std::pair<uint32_t, uint32_t>> &ranges)
-    : FrameData(frame), m_ranges(ranges) {
-        m_data = (uint8_t*)malloc(sz);
+    : BufferFrameData((uint8_t*)malloc(sz)) {
+        this->frame = frame;
+        m_ranges = std::make_shared<const std::vector<std::pair<uint32_t, uint32_t>>>(ranges);
     }
     virtual ~UncompressedFrameData() {
         free(m_data);
     }
+};
 
-    virtual void readFrame(uint8_t *data) {
-        uint32_t offset = 0;
-        for (auto &rng : m_ranges) {
-            uint32_t toRead = rng.second;
-            memcpy(&data[rng.first], &m_data[offset], toRead);
-            offset += toRead;
+//make sure we don't read beyond the end of the sequence data, ranges which
+//start past the end are dropped.  Returns the number of channels left.
+static uint32_t clipReadRanges(std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t channelCount) {
+    uint32_t total = 0;
+    for (auto it = ranges.begin(); it != ranges.end(); ) {
+        if (it->first >= channelCount) {
+            it = ranges.erase(it);
+            continue;
+        }
+        if (it->second > (channelCount - it->first)) {
+            it->second = channelCount - it->first;
         }
+        total += it->second;
+        ++it;
     }
+    return total;
+}
+
+bool FSEQFile::fillFrame(uint32_t frame, BufferFrameData *fd) {
+    fd->frame = frame;
+    fd->m_ranges = m_readRanges;
+    return readFrameData(frame, fd->m_data);
+}
 
-    uint8_t *m_data;
-    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
-};
 void V1FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) {
     m_rangesToRead = ranges;
-    m_dataBlockSize = 0;
-    for (auto &rng : m_rangesToRead) {
-        //make sure we don't read beyond the end of the sequence data
-        int toRead = rng.second;
-        if ((rng.first + toRead) > m_seqChannelCount) {
-            toRead = m_seqChannelCount - rng.first;
-            rng.second = toRead;
-        }
-        m_dataBlockSize += toRead;
-    }
+    m_dataBlockSize = clipReadRanges(m_rangesToRead, m_seqChannelCount);
+    setReadRanges(m_rangesToRead);
     FrameData *f = getFrame(0);
     if (f) {
         delete f;
@@ -537,20 +861,36 @@ FrameData *V1FSEQFile::getFrame(uint32_t frame) {
     offset *= frame;
     offset += m_seqChanDataOffset;
 
+    FrameData *mapped = getMappedFrame(frame, offset, m_seqChannelCount, false);
+    if (mapped) {
+        return mapped;
+    }
     UncompressedFrameData *data = new UncompressedFrameData(frame, m_dataBlockSize, m_rangesToRead);
+    readFrameData(frame, data->m_data);
+    return data;
+}
+
+bool V1FSEQFile::readFrameData(uint32_t frame, uint8_t *data) {
+    uint64_t offset = m_seqChannelCount;
+    offset *= frame;
+    offset += m_seqChanDataOffset;
+    if (readMappedFrameData(offset, m_seqChannelCount, false, data)) {
+        return true;
+    }
+
     if (seek(offset, SEEK_SET)) {
         LogErr(VB_SEQUENCE, "Failed to seek to proper offset for channel data for frame %d! %" PRIu64 "\n", frame, offset);
-        return data;
+        return false;
     }
     uint32_t sz = 0;
     //read the ranges into the buffer
-    for (auto &rng : data->m_ranges) {
+    for (auto &rng : m_rangesToRead) {
         if (rng.first < m_seqChannelCount) {
             int toRead = rng.second;
             uint64_t doffset = offset;
             doffset += rng.first;
             seek(doffset, SEEK_SET);
-            size_t bread = read(&data->m_data[sz], toRead);
+            size_t bread = read(&data[sz], toRead);
             if (bread != toRead) {
                 LogErr(VB_SEQUENCE, "Failed to read channel data for frame %d!   Needed to read %d but read %d\n",
                        frame, toRead, (int)bread);
@@ -558,7 +898,7 @@ FrameData *V1FSEQFile::getFrame(uint32_t frame) {
             sz += toRead;
         }
     }
-    return data;
+    return true;
 }
 
 void V1FSEQFile::addFrame(uint32_t frame,
@@ -575,6 +915,40 @@ uint32_t V1FSEQFile::getMaxChannel() const {
 }
 
 static const int V2FSEQ_HEADER_SIZE = 32;
+//header[21] holds the low 8 bits of the compression block count.  2.1 files
+//can use the high nibble of header[20] (above the compression type) for bits 8-11,
+//2.0 readers don't know about it so it's only used when asked for
+static const int V2FSEQ_MAX_BLOCKS_V20 = 255;
+static const int V2FSEQ_MAX_BLOCKS = 4095;
+//computeMaxBlocks always leaves room for at least this many blocks
+static const int V2FSEQ_MIN_INDEX_BLOCKS = 3;
+//compression blocks are kept short so a seek only has to decompress a
+//fraction of a second of data to reach any frame
+static const int V2FSEQ_BLOCK_TIME_MS = 500;
+static const uint64_t V2FSEQ_MIN_BLOCK_SIZE = 64 * 1024;
+static const uint64_t V2FSEQ_MAX_BLOCK_SIZE = 4 * 1024 * 1024;
+//blocks that decode to more than this (older files with up to 255 blocks)
+//are decoded a few frames at a time instead of into whole block buffers
+static const uint64_t V2FSEQ_MAX_DECODE_BUFFER_SIZE = V2FSEQ_MAX_BLOCK_SIZE;
+static const uint32_t V2FSEQ_DECODE_WINDOW_FRAMES = 4;
+static const uint64_t V2FSEQ_DECODE_INPUT_SIZE = 64 * 1024;
+//header[19] flags
+static const uint8_t V2FSEQ_FLAG_XOR_FRAMES = 0x01;
+
+//dst = a ^ b, done a word at a time, dst can be the same as a
+inline void xorBuffer(uint8_t *dst, const uint8_t *a, const uint8_t *b, uint64_t len) {
+    uint64_t x = 0;
+    for (; (x + 8) <= len; x += 8) {
+        uint64_t va, vb;
+        memcpy(&va, &a[x], 8);
+        memcpy(&vb, &b[x], 8);
+        va ^= vb;
+        memcpy(&dst[x], &va, 8);
+    }
+    for (; x < len; x++) {
+        dst[x] = a[x] ^ b[x];
+    }
+}
 #if !defined(NO_ZLIB) || !defined(NO_ZSTD)
 static const int V2FSEQ_OUT_BUFFER_SIZE = 1024*1024; //1M output buffer
 static const int V2FSEQ_OUT_BUFFER_FLUSH_SIZE = 900 * 1024; //90% full, flush it
@@ -591,11 +965,18 @@ public:
 
 
     virtual uint8_t getCompressionType() = 0;
-    virtual FrameData *getFrame(uint32_t frame) = 0;
+    virtual bool readFrameData(uint32_t frame, uint8_t *data) = 0;
+    virtual FrameData *getFrame(uint32_t frame) {
+        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        readFrameData(frame, data->m_data);
+        return data;
+    }
 
     virtual uint32_t computeMaxBlocks() = 0;
     virtual void addFrame(uint32_t frame, const uint8_t *data) = 0;
     virtual void finalize() = 0;
+    //channel ranges (in the packed frame data) that will be read
+    virtual void setChannelRanges(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) {}
 
     int seek(uint64_t location, int origin) {
         return m_file->seek(location, origin);
@@ -609,9 +990,24 @@ public:
     uint64_t read(void *ptr, uint64_t size) {
         return m_file->read(ptr, size);
     }
+    uint64_t readAt(void *ptr, uint64_t size, uint64_t pos) {
+        return m_file->readAt(ptr, size, pos);
+    }
     void preload(uint64_t pos, uint64_t size) {
         m_file->preload(pos, size);
     }
+    uint64_t readCachedAt(void *ptr, uint64_t size, uint64_t pos) {
+        return m_file->readCachedAt(ptr, size, pos);
+    }
+    bool isCached(uint64_t pos, uint64_t size) {
+        return m_file->isCached(pos, size);
+    }
+    FrameData *getMappedFrame(uint32_t frame, uint64_t offset, uint32_t size, bool packed) {
+        return m_file->getMappedFrame(frame, offset, size, packed);
+    }
+    bool readMappedFrameData(uint64_t offset, uint32_t size, bool packed, uint8_t *data) {
+        return m_file->readMappedFrameData(offset, size, packed, data);
+    }
 
     V2FSEQFile *m_file;
     uint64_t   m_seqChanDataOffset;
@@ -626,24 +1022,36 @@ public:
     virtual uint32_t computeMaxBlocks() override {return 0;}
 
     virtual FrameData *getFrame(uint32_t frame) override {
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
         uint64_t offset = m_file->getChannelCount();
         offset *= frame;
         offset += m_seqChanDataOffset;
+        FrameData *mapped = getMappedFrame(frame, offset, m_file->getChannelCount(), !m_file->m_sparseRanges.empty());
+        if (mapped) {
+            return mapped;
+        }
+        return V2Handler::getFrame(frame);
+    }
+    virtual bool readFrameData(uint32_t frame, uint8_t *data) override {
+        uint64_t offset = m_file->getChannelCount();
+        offset *= frame;
+        offset += m_seqChanDataOffset;
+        if (readMappedFrameData(offset, m_file->getChannelCount(), !m_file->m_sparseRanges.empty(), data)) {
+            return true;
+        }
         if (seek(offset, SEEK_SET)) {
             LogErr(VB_SEQUENCE, "Failed to seek to proper offset for channel data! %" PRIu64 "\n", offset);
-            return data;
+            return false;
         }
         if (m_file->m_sparseRanges.empty()) {
             uint32_t sz = 0;
             //read the ranges into the buffer
-            for (auto &rng : data->m_ranges) {
+            for (auto &rng : m_file->m_rangesToRead) {
                 if (rng.first < m_file->getChannelCount()) {
                     int toRead = rng.second;
                     uint64_t doffset = offset;
                     doffset += rng.first;
                     seek(doffset, SEEK_SET);
-                    size_t bread = read(&data->m_data[sz], toRead);
+                    size_t bread = read(&data[sz], toRead);
                     if (bread != toRead) {
                         LogErr(VB_SEQUENCE, "Failed to read channel data!   Needed to read %d but read %d\n", toRead, (int)bread);
                     }
@@ -651,12 +1059,12 @@ public:
                 }
             }
         } else {
-            size_t bread = read(data->m_data, m_file->m_dataBlockSize);
+            size_t bread = read(data, m_file->m_dataBlockSize);
             if (bread != m_file->m_dataBlockSize) {
                 LogErr(VB_SEQUENCE, "Failed to read channel data!   Needed to read %d but read %d\n", m_file->m_dataBlockSize, (int)bread);
             }
         }
-        return data;
+        return true;
     }
     virtual void addFrame(uint32_t frame, const uint8_t *data) override {
         if (m_file->m_sparseRanges.empty()) {
@@ -673,52 +1081,647 @@ public:
 };
 class V2CompressedHandler : public V2Handler {
 public:
-    V2CompressedHandler(V2FSEQFile *f) : V2Handler(f), m_maxBlocks(0), m_curBlock(99999), m_framesPerBlock(0), m_curFrameInBlock(0) {
+    V2CompressedHandler(V2FSEQFile *f) : V2Handler(f), m_maxBlocks(0), m_curBlock(99999), m_framesPerBlock(0), m_curFrameInBlock(0),
+        m_decodeThread(nullptr), m_stopDecoding(false), m_requestedBlock(-1),
+        m_windowBlock(UINT32_MAX), m_windowNext(0), m_windowReadPos(0), m_windowInPos(0), m_windowInLen(0),
+        m_curJob(nullptr), m_stopCompressing(false) {
         if (!m_file->m_frameOffsets.empty()) {
             m_maxBlocks = m_file->m_frameOffsets.size() - 1;
         }
+        for (auto &b : m_decodedBlocks) {
+            b.block = -1;
+            b.ready = false;
+            b.data = nullptr;
+        }
+    }
+    //the decode and compress threads call the compression virtuals so each
+    //handler's destructor has to stop them before its state goes away
+    virtual ~V2CompressedHandler() {
+        stopDecodeThread();
+        stopCompressThreads();
+        for (auto j : m_compressJobs) {
+            delete j;
+        }
+        if (m_curJob) {
+            delete m_curJob;
+        }
+        for (auto &b : m_decodedBlocks) {
+            if (b.data) {
+                free(b.data);
+            }
+        }
+    }
+
+    //decompress a full block of compressed data into out which is sized for
+    //all the frames in the block.  Called from the decode thread, returns
+    //the number of bytes decompressed.
+    virtual uint64_t decompressBlock(uint8_t *in, uint64_t inSize, uint8_t *out, uint64_t outSize) = 0;
+    //Incremental decompression for large blocks.  startWindowDecode starts
+    //a new block, decompressWindow decompresses from in until out is full or
+    //in is used up.  inUsed is set to the input consumed and the number of
+    //bytes put in out is returned.  Only called from the reading thread.
+    virtual bool supportsWindowDecode() const { return false; }
+    virtual void startWindowDecode() {}
+    virtual uint64_t decompressWindow(const uint8_t *in, uint64_t inSize, uint64_t &inUsed, uint8_t *out, uint64_t outSize) {
+        inUsed = 0;
+        return 0;
+    }
+    //compress len bytes as a complete, independent stream into out.  Can be
+    //called from several compression threads at once
+    virtual void compressToBuffer(const uint8_t *data, uint64_t len, std::vector<uint8_t> &out) = 0;
+
+    uint32_t getNumBlocks() const {
+        return m_file->m_frameOffsets.empty() ? 0 : m_file->m_frameOffsets.size() - 1;
+    }
+    uint32_t getBlockFrames(uint32_t block) const {
+        uint32_t lastFrame = m_file->m_frameOffsets[block + 1].first;
+        if (lastFrame > m_file->getNumFrames()) {
+            lastFrame = m_file->getNumFrames();
+        }
+        return lastFrame - m_file->m_frameOffsets[block].first;
+    }
+    uint64_t getBlockDataSize(uint32_t block) const {
+        uint64_t sz = getBlockFrames(block);
+        sz *= m_file->getChannelCount();
+        return sz;
+    }
+
+    // Unstriped blocks are handled as a single stripe covering every channel.
+    // The needed stripes are decoded one after the other, each holding all the
+    // frames in the block for that stripe's channels.
+    uint32_t getStripeCount() const {
+        return m_file->m_channelStripes > 1 ? m_file->m_channelStripes : 1;
+    }
+    uint32_t getStripeSize(uint32_t stripe) const {
+        uint32_t w = m_file->getStripeWidth();
+        uint32_t start = stripe * w;
+        if (start >= m_file->getChannelCount()) {
+            return 0;
+        }
+        return std::min(w, m_file->getChannelCount() - start);
+    }
+    uint64_t getStripeOffset(uint32_t block, uint32_t stripe) const {
+        if (getStripeCount() == 1) {
+            return m_file->m_frameOffsets[block + stripe].second;
+        }
+        return m_file->m_stripeOffsets[block * getStripeCount() + stripe];
+    }
+    bool isStripeNeeded(uint32_t stripe) const {
+        return m_neededStripes.empty() || m_neededStripes[stripe];
+    }
+    //offset of a needed stripe in a decoded block
+    uint64_t getDecodedStripeOffset(uint32_t frames, uint32_t stripe) const {
+        uint32_t slot = m_stripeSlots.empty() ? stripe : m_stripeSlots[stripe];
+        return (uint64_t)frames * slot * m_file->getStripeWidth();
+    }
+    uint64_t getDecodedBlockSize(uint32_t block) const {
+        uint64_t sz = 0;
+        for (uint32_t s = 0; s < getStripeCount(); s++) {
+            if (isStripeNeeded(s)) {
+                sz += getStripeSize(s);
+            }
+        }
+        return sz * getBlockFrames(block);
+    }
+    void copyChannels(const uint8_t *blockData, uint32_t frames, uint32_t fidx,
+                      uint32_t start, uint32_t len, uint8_t *dest) const {
+        uint32_t w = m_file->getStripeWidth();
+        while (len) {
+            uint32_t stripe = start / w;
+            uint32_t sw = getStripeSize(stripe);
+            uint32_t off = start - stripe * w;
+            uint32_t n = std::min(len, sw - off);
+            if (isStripeNeeded(stripe)) {
+                memcpy(dest, &blockData[getDecodedStripeOffset(frames, stripe) + (uint64_t)fidx * sw + off], n);
+            } else {
+                //stripes that aren't needed are never decoded
+                memset(dest, 0, n);
+            }
+            dest += n;
+            start += n;
+            len -= n;
+        }
+    }
+
+    bool isWindowedBlock(uint32_t block) const {
+        return getStripeCount() == 1 && supportsWindowDecode()
+            && getBlockDataSize(block) > V2FSEQ_MAX_DECODE_BUFFER_SIZE;
+    }
+    //decode the next frame of the windowed block into the window
+    void decodeWindowFrame() {
+        uint32_t cc = m_file->getChannelCount();
+        uint8_t *out = &m_window[(uint64_t)(m_windowNext % V2FSEQ_DECODE_WINDOW_FRAMES) * cc];
+        uint64_t blockEnd = getStripeOffset(m_windowBlock, 1);
+        uint64_t got = 0;
+        while (got < cc) {
+            if (m_windowInPos == m_windowInLen && m_windowReadPos < blockEnd) {
+                //pull in more of the compressed block
+                uint64_t len = std::min(V2FSEQ_DECODE_INPUT_SIZE, blockEnd - m_windowReadPos);
+                m_windowInLen = readCachedAt(&m_windowIn[0], len, m_windowReadPos);
+                m_windowInPos = 0;
+                m_windowReadPos += len;
+                if (m_windowInLen != len) {
+                    LogErr(VB_SEQUENCE, "Failed to read channel data for block %d!   Needed to read %" PRIu64 " but read %" PRIu64 "\n",
+                           m_windowBlock, len, m_windowInLen);
+                }
+            }
+            uint64_t used = 0;
+            uint64_t n = decompressWindow(&m_windowIn[m_windowInPos], m_windowInLen - m_windowInPos, used, &out[got], cc - got);
+            m_windowInPos += used;
+            got += n;
+            if (n == 0 && used == 0) {
+                break;
+            }
+        }
+        if (got < cc) {
+            LogErr(VB_SEQUENCE, "Failed to decompress frame %d of block %d!   Needed %d but decompressed %" PRIu64 "\n",
+                   m_windowNext, m_windowBlock, cc, got);
+            memset(&out[got], 0, cc - got);
+        }
+        if (m_file->m_xorFrames && m_windowNext > 0) {
+            uint8_t *prev = &m_window[(uint64_t)((m_windowNext - 1) % V2FSEQ_DECODE_WINDOW_FRAMES) * cc];
+            xorBuffer(out, out, prev, cc);
+        }
+        m_windowNext++;
+    }
+    //Returns the frame of a windowed block, decoding up to it.  The last few
+    //frames stay in the window, going back further restarts the block.
+    const uint8_t *getWindowFrame(uint32_t block, uint32_t fidx) {
+        if (m_window.empty()) {
+            m_window.resize((uint64_t)V2FSEQ_DECODE_WINDOW_FRAMES * m_file->getChannelCount());
+            m_windowIn.resize(V2FSEQ_DECODE_INPUT_SIZE);
+        }
+        if (m_windowBlock != block || fidx + V2FSEQ_DECODE_WINDOW_FRAMES < m_windowNext) {
+            m_windowBlock = block;
+            m_windowNext = 0;
+            m_windowReadPos = getStripeOffset(block, 0);
+            m_windowInPos = m_windowInLen = 0;
+            startWindowDecode();
+        }
+        while (m_windowNext <= fidx) {
+            decodeWindowFrame();
+        }
+        return &m_window[(uint64_t)(fidx % V2FSEQ_DECODE_WINDOW_FRAMES) * m_file->getChannelCount()];
+    }
+
+    virtual void setChannelRanges(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) override {
+        //anything already decoded may be missing stripes for the new ranges
+        stopDecodeThread();
+        for (auto &b : m_decodedBlocks) {
+            if (b.data) {
+                free(b.data);
+            }
+            b.block = -1;
+            b.ready = false;
+            b.data = nullptr;
+        }
+        m_stopDecoding = false;
+        m_requestedBlock = -1;
+
+        m_neededStripes.clear();
+        m_stripeSlots.clear();
+        uint32_t stripes = getStripeCount();
+        if (stripes > 1) {
+            uint32_t w = m_file->getStripeWidth();
+            m_neededStripes.resize(stripes, false);
+            for (auto &rng : ranges) {
+                for (uint32_t x = rng.first / w; x < stripes && (x * w) < (rng.first + rng.second); x++) {
+                    m_neededStripes[x] = true;
+                }
+            }
+            //only the last stripe is narrower, so packing the needed
+            //stripes in order keeps each slot a full stripe wide
+            uint32_t slot = 0;
+            m_stripeSlots.resize(stripes, 0);
+            for (uint32_t x = 0; x < stripes; x++) {
+                if (m_neededStripes[x]) {
+                    m_stripeSlots[x] = slot++;
+                }
+            }
+        }
+    }
+    uint32_t findBlock(uint32_t frame) {
+        if (m_curBlock < getNumBlocks()
+            && frame >= m_file->m_frameOffsets[m_curBlock].first
+            && frame < m_file->m_frameOffsets[m_curBlock + 1].first) {
+            return m_curBlock;
+        }
+        //not in the current block, binary search the index
+        auto it = std::upper_bound(m_file->m_frameOffsets.begin(), m_file->m_frameOffsets.end() - 1, frame,
+                                   [](uint32_t f, const std::pair<uint32_t, uint64_t> &b) { return f < b.first; });
+        m_curBlock = it == m_file->m_frameOffsets.begin() ? 0 : (it - m_file->m_frameOffsets.begin() - 1);
+        return m_curBlock;
+    }
+
+    virtual bool readFrameData(uint32_t frame, uint8_t *data) override {
+        if (getNumBlocks() == 0) {
+            return false;
+        }
+        int block = findBlock(frame);
+
+        std::unique_lock<std::mutex> lock(m_decodeLock);
+        if (m_decodeThread == nullptr) {
+            startDecodeThread();
+        }
+        if (m_requestedBlock != block) {
+            //for windowed blocks this gets the next block decoded ahead
+            m_requestedBlock = block;
+            m_decodeSignal.notify_all();
+        }
+        uint32_t fidx = frame - m_file->m_frameOffsets[block].first;
+        uint32_t frames = getBlockFrames(block);
+        const uint8_t *blockData;
+        if (isWindowedBlock(block)) {
+            lock.unlock();
+            blockData = getWindowFrame(block, fidx);
+            frames = 1;
+            fidx = 0;
+        } else {
+            DecodedBlock *db = findDecodedBlock(block);
+            while (db == nullptr) {
+                m_decodedSignal.wait(lock);
+                db = findDecodedBlock(block);
+            }
+            //the decode thread never touches the requested block so this
+            //is safe to use without the lock
+            lock.unlock();
+            blockData = db->data;
+        }
+        if (!m_file->m_sparseRanges.empty()) {
+            copyChannels(blockData, frames, fidx, 0, m_file->getChannelCount(), data);
+        } else {
+            uint32_t sz = 0;
+            //read the ranges into the buffer
+            for (auto &rng : m_file->m_rangesToRead) {
+                if (rng.first < m_file->getChannelCount()) {
+                    copyChannels(blockData, frames, fidx, rng.first, rng.second, &data[sz]);
+                    sz += rng.second;
+                }
+            }
+        }
+        return true;
+    }
+
+    void startDecodeThread() {
+        uint64_t maxSize = 0;
+        for (uint32_t x = 0; x < getNumBlocks(); x++) {
+            if (!isWindowedBlock(x)) {
+                maxSize = std::max(maxSize, getDecodedBlockSize(x));
+            }
+        }
+        //two buffers, one for the block being played and one for the next
+        //block that is decompressed in the background
+        for (auto &b : m_decodedBlocks) {
+            b.data = (uint8_t*)calloc(1, maxSize ? maxSize : 1);
+        }
+        m_decodeThread = new std::thread(&V2CompressedHandler::decodeLoop, this);
+    }
+    void stopDecodeThread() {
+        if (m_decodeThread) {
+            std::unique_lock<std::mutex> lock(m_decodeLock);
+            m_stopDecoding = true;
+            lock.unlock();
+            m_decodeSignal.notify_all();
+            m_decodeThread->join();
+            delete m_decodeThread;
+            m_decodeThread = nullptr;
+        }
+    }
+
+    void decodeLoop() {
+        std::vector<uint8_t> inBuffer;
+        std::unique_lock<std::mutex> lock(m_decodeLock);
+        while (!m_stopDecoding) {
+            //decode the requested block first, then the one after it so it's
+            //ready by the time playback gets there
+            int block = -1;
+            for (int b = m_requestedBlock; b >= 0 && b <= (m_requestedBlock + 1) && b < (int)getNumBlocks(); b++) {
+                if (!haveDecodedBlock(b) && !isWindowedBlock(b)) {
+                    block = b;
+                    break;
+                }
+            }
+            if (block == -1) {
+                m_decodeSignal.wait(lock);
+                continue;
+            }
+            DecodedBlock *db = &m_decodedBlocks[0];
+            if (m_decodedBlocks[0].block == m_requestedBlock
+                || (block == m_requestedBlock && m_decodedBlocks[0].block == (m_requestedBlock + 1))) {
+                db = &m_decodedBlocks[1];
+            }
+            db->block = block;
+            db->ready = false;
+            lock.unlock();
+
+            uint32_t frames = getBlockFrames(block);
+            uint32_t stripes = getStripeCount();
+            for (uint32_t s = 0; s < stripes;) {
+                if (!isStripeNeeded(s)) {
+                    s++;
+                    continue;
+                }
+                //read each run of needed stripes with a single read
+                uint32_t e = s + 1;
+                while (e < stripes && isStripeNeeded(e)) {
+                    e++;
+                }
+                uint64_t offset = getStripeOffset(block, s);
+                uint64_t len = getStripeOffset(block, e) - offset;
+                if (inBuffer.size() < len) {
+                    inBuffer.resize(len);
+                }
+                uint64_t bread = readCachedAt(&inBuffer[0], len, offset);
+                if (bread != len) {
+                    LogErr(VB_SEQUENCE, "Failed to read channel data for block %d!   Needed to read %" PRIu64 " but read %" PRIu64 "\n", block, len, bread);
+                }
+                if ((uint32_t)(block + 1) < getNumBlocks()) {
+                    //let the kernel know that we'll likely need the next block in the near future
+                    uint64_t off2 = getStripeOffset(block + 1, s);
+                    uint64_t len2 = getStripeOffset(block + 1, e) - off2;
+                    if (!isCached(off2, len2)) {
+                        preload(off2, len2);
+                    }
+                }
+
+                for (; s < e; s++) {
+                    uint64_t inStart = getStripeOffset(block, s) - offset;
+                    uint64_t inSize = getStripeOffset(block, s + 1) - offset;
+                    inSize = std::min(inSize, bread);
+                    inSize = inSize > inStart ? inSize - inStart : 0;
+                    uint8_t *out = &db->data[getDecodedStripeOffset(frames, s)];
+                    uint64_t outSize = (uint64_t)frames * getStripeSize(s);
+                    uint64_t decoded = decompressBlock(&inBuffer[inStart], inSize, out, outSize);
+                    if (decoded < outSize) {
+                        LogErr(VB_SEQUENCE, "Failed to decompress channel data for block %d!   Needed %" PRIu64 " but decompressed %" PRIu64 "\n", block, outSize, decoded);
+                        memset(&out[decoded], 0, outSize - decoded);
+                    }
+                    if (m_file->m_xorFrames) {
+                        //undo the XOR against the previous frame
+                        uint32_t sw = getStripeSize(s);
+                        for (uint32_t f = 1; f < frames; f++) {
+                            uint8_t *row = &out[(uint64_t)f * sw];
+                            xorBuffer(row, row, row - sw, sw);
+                        }
+                    }
+                }
+            }
+
+            lock.lock();
+            db->ready = true;
+            m_decodedSignal.notify_all();
+        }
     }
-    virtual ~V2CompressedHandler() {}
 
     virtual uint32_t computeMaxBlocks() override {
         if (m_maxBlocks > 0) {
             return m_maxBlocks;
         }
-        //determine a good number of compression blocks
-        uint64_t datasize = m_file->getChannelCount() * m_file->getNumFrames();
-        uint64_t numBlocks = datasize;
-        numBlocks /= (64*2014); //at least 64K per block
-        if (numBlocks > 255) {
-            //need a lot of blocks, use as many as we can
-            numBlocks = 255;
-        } else if (numBlocks < 1) {
-            numBlocks = 1;
-        }
-        m_framesPerBlock = m_file->getNumFrames() / numBlocks;
-        if (m_framesPerBlock < 10) m_framesPerBlock = 10;
+        //determine a good number of compression blocks.  Aim for about
+        //V2FSEQ_BLOCK_TIME_MS of frames per block, but keep blocks big
+        //enough to compress well and small enough to decompress quickly
+        uint64_t frameSize = m_file->getChannelCount();
+        if (frameSize < 1) frameSize = 1;
+        int stepTime = m_file->getStepTime() ? m_file->getStepTime() : 50;
+        uint64_t framesPerBlock = V2FSEQ_BLOCK_TIME_MS / stepTime;
+        if ((framesPerBlock * frameSize) > V2FSEQ_MAX_BLOCK_SIZE) {
+            framesPerBlock = V2FSEQ_MAX_BLOCK_SIZE / frameSize;
+        }
+        if ((framesPerBlock * frameSize) < V2FSEQ_MIN_BLOCK_SIZE) {
+            framesPerBlock = (V2FSEQ_MIN_BLOCK_SIZE + frameSize - 1) / frameSize;
+        }
+        if (framesPerBlock < 1) framesPerBlock = 1;
+        m_framesPerBlock = framesPerBlock;
         m_curFrameInBlock = 0;
         m_curBlock = 0;
 
-        numBlocks = m_file->getNumFrames() / m_framesPerBlock + 1;
-        while (numBlocks > 255) {
+        // first block is going to be smaller, so add some blocks.
+        // Each stripe of a block takes an index entry.
+        uint64_t maxIndex = m_file->getVersionMinor() >= 1 ? V2FSEQ_MAX_BLOCKS : V2FSEQ_MAX_BLOCKS_V20;
+        uint64_t numBlocks = m_file->getNumFrames() / m_framesPerBlock + V2FSEQ_MIN_INDEX_BLOCKS;
+        while ((numBlocks * getStripeCount()) > maxIndex && numBlocks > V2FSEQ_MIN_INDEX_BLOCKS) {
             m_framesPerBlock++;
-            numBlocks = m_file->getNumFrames() / m_framesPerBlock + 1;
-        }
-        // first block is going to be smaller, so add some blocks
-        if (numBlocks < 254) {
-            numBlocks += 2;
-        } else if (numBlocks < 255) {
-            numBlocks++;
+            numBlocks = m_file->getNumFrames() / m_framesPerBlock + V2FSEQ_MIN_INDEX_BLOCKS;
         }
+        numBlocks *= getStripeCount();
         m_maxBlocks = numBlocks;
         m_curBlock = 0;
         return m_maxBlocks;
     }
 
+    //copy the channels stored in the file (the sparse ranges) out of a full frame
+    void packFrame(const uint8_t *data, uint8_t *dest) const {
+        if (m_file->m_sparseRanges.empty()) {
+            memcpy(dest, data, m_file->getChannelCount());
+        } else {
+            for (auto &a : m_file->m_sparseRanges) {
+                memcpy(dest, &data[a.first], a.second);
+                dest += a.second;
+            }
+        }
+    }
+    //for m_xorFrames, returns the packed frame XORed with the previous frame
+    //in the block, the first frame of each block is stored as is
+    const uint8_t *deltaFrame(const uint8_t *data) {
+        uint32_t cc = m_file->getChannelCount();
+        m_lastFrame.resize(cc);
+        m_curFrame.resize(cc);
+        m_deltaFrame.resize(cc);
+        if (m_curFrameInBlock == 0) {
+            packFrame(data, &m_lastFrame[0]);
+            return &m_lastFrame[0];
+        }
+        packFrame(data, &m_curFrame[0]);
+        xorBuffer(&m_deltaFrame[0], &m_curFrame[0], &m_lastFrame[0], cc);
+        std::swap(m_lastFrame, m_curFrame);
+        return &m_deltaFrame[0];
+    }
+
+    //at the end of a block, start a new one if we hit the max per block OR we're in
+    //the first block and hit frame #10.  We want the first block to be small so startup
+    //is quicker and we can get the first few frames as fast as possible.
+    bool isBlockFull() const {
+        //m_curBlock is the number of blocks already completed, each stripe
+        //of a block takes an index entry.  Never start a block that won't fit.
+        if (((m_curBlock + 2) * getStripeCount()) > m_maxBlocks) {
+            return false;
+        }
+        if (m_curBlock == 0 && m_curFrameInBlock == 10) {
+            return true;
+        }
+        return m_curFrameInBlock >= m_framesPerBlock;
+    }
+
+    // Striped files and multithreaded compression buffer the frames of a
+    // block and compress the whole block (each stripe separately) once it's
+    // complete.  Otherwise frames are streamed into the compressor as they
+    // are added.  Both produce identical output.
+    class CompressJob {
+    public:
+        uint32_t startFrame;
+        uint32_t frames;
+        std::vector<uint8_t> data;
+        std::vector<std::vector<uint8_t>> stripes;
+        bool done;
+    };
+    virtual bool useBlockBuffer() const {
+        return getStripeCount() > 1 || m_file->m_compressionThreads > 1;
+    }
+    void addBufferedFrame(uint32_t frame, const uint8_t *data) {
+        uint32_t cc = m_file->getChannelCount();
+        if (m_curFrameInBlock == 0) {
+            m_curJob = new CompressJob();
+            m_curJob->startFrame = frame;
+            m_curJob->done = false;
+        }
+        uint64_t pos = m_curJob->data.size();
+        m_curJob->data.resize(pos + cc);
+        packFrame(data, &m_curJob->data[pos]);
+        m_curFrameInBlock++;
+        if (isBlockFull()) {
+            finishBufferedBlock();
+        }
+    }
+    void finishBufferedBlock() {
+        CompressJob *job = m_curJob;
+        m_curJob = nullptr;
+        job->frames = m_curFrameInBlock;
+        m_curFrameInBlock = 0;
+        m_curBlock++;
+
+        if (m_file->m_compressionThreads <= 1) {
+            compressJob(job);
+            writeJob(job);
+            delete job;
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_compressLock);
+        if (m_compressThreads.empty()) {
+            for (int x = 0; x < m_file->m_compressionThreads; x++) {
+                m_compressThreads.push_back(new std::thread(&V2CompressedHandler::compressLoop, this));
+            }
+        }
+        m_compressQueue.push_back(job);
+        m_compressJobs.push_back(job);
+        lock.unlock();
+        m_compressSignal.notify_one();
+        //keep a couple blocks per thread queued up, write out whatever is done
+        writeCompressedJobs(m_file->m_compressionThreads * 2);
+    }
+    //finish any block in progress and write out everything still queued
+    void finishBufferedBlocks() {
+        if (m_curFrameInBlock) {
+            finishBufferedBlock();
+        }
+        writeCompressedJobs(0);
+        stopCompressThreads();
+    }
+    //write completed jobs in order, waiting until at most maxPending are left
+    void writeCompressedJobs(size_t maxPending) {
+        std::unique_lock<std::mutex> lock(m_compressLock);
+        while (!m_compressJobs.empty()) {
+            CompressJob *job = m_compressJobs.front();
+            if (!job->done) {
+                if (m_compressJobs.size() <= maxPending) {
+                    break;
+                }
+                m_compressedSignal.wait(lock);
+                continue;
+            }
+            m_compressJobs.pop_front();
+            lock.unlock();
+            writeJob(job);
+            delete job;
+            lock.lock();
+        }
+    }
+    void compressLoop() {
+        std::unique_lock<std::mutex> lock(m_compressLock);
+        while (true) {
+            if (m_compressQueue.empty()) {
+                if (m_stopCompressing) {
+                    break;
+                }
+                m_compressSignal.wait(lock);
+                continue;
+            }
+            CompressJob *job = m_compressQueue.front();
+            m_compressQueue.pop_front();
+            lock.unlock();
+            compressJob(job);
+            lock.lock();
+            job->done = true;
+            m_compressedSignal.notify_all();
+        }
+    }
+    void stopCompressThreads() {
+        std::unique_lock<std::mutex> lock(m_compressLock);
+        m_stopCompressing = true;
+        lock.unlock();
+        m_compressSignal.notify_all();
+        for (auto t : m_compressThreads) {
+            t->join();
+            delete t;
+        }
+        m_compressThreads.clear();
+        m_stopCompressing = false;
+    }
+    void compressJob(CompressJob *job) {
+        uint32_t cc = m_file->getChannelCount();
+        uint32_t w = m_file->getStripeWidth();
+        if (m_file->m_xorFrames) {
+            //work backwards so each frame is XORed with the original previous frame
+            for (uint32_t f = job->frames - 1; f > 0; f--) {
+                uint8_t *row = &job->data[(uint64_t)f * cc];
+                xorBuffer(row, row, row - cc, cc);
+            }
+        }
+        job->stripes.resize(getStripeCount());
+        if (getStripeCount() == 1) {
+            compressToBuffer(&job->data[0], job->data.size(), job->stripes[0]);
+            return;
+        }
+        std::vector<uint8_t> stripe;
+        for (uint32_t s = 0; s < getStripeCount(); s++) {
+            uint32_t sw = getStripeSize(s);
+            stripe.resize((uint64_t)sw * job->frames);
+            for (uint32_t f = 0; f < job->frames; f++) {
+                memcpy(&stripe[(uint64_t)f * sw], &job->data[(uint64_t)f * cc + s * w], sw);
+            }
+            compressToBuffer(&stripe[0], stripe.size(), job->stripes[s]);
+        }
+    }
+    void writeJob(CompressJob *job) {
+        for (uint32_t s = 0; s < job->stripes.size(); s++) {
+            uint64_t offset = tell();
+            if (s == 0) {
+                m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(job->startFrame, offset));
+            }
+            if (getStripeCount() > 1) {
+                m_file->m_stripeOffsets.push_back(offset);
+            }
+            write(&job->stripes[s][0], job->stripes[s].size());
+        }
+    }
+
     virtual void finalize() override {
         uint64_t curr = tell();
         uint64_t off = V2FSEQ_HEADER_SIZE;
         seek(off, SEEK_SET);
+        if (getStripeCount() > 1) {
+            int count = m_file->m_stripeOffsets.size();
+            m_file->m_stripeOffsets.push_back(curr);
+            for (int x = 0 ; x < count; x++) {
+                uint8_t buf[8];
+                write4ByteUInt(buf, m_file->m_frameOffsets[x / getStripeCount()].first);
+                uint32_t len = m_file->m_stripeOffsets[x + 1] - m_file->m_stripeOffsets[x];
+                write4ByteUInt(&buf[4], len);
+                write(buf, 8);
+            }
+            m_file->m_stripeOffsets.pop_back();
+            seek(curr, SEEK_SET);
+            return;
+        }
         int count = m_file->m_frameOffsets.size();
         m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(99999999, curr));
         for (int x = 0 ; x < count; x++) {
@@ -743,6 +1746,64 @@ public:
     uint32_t m_curFrameInBlock;
     uint32_t m_curBlock;
     uint32_t m_maxBlocks;
+
+    // decompressed blocks for reading, filled in by the decode thread
+    class DecodedBlock {
+    public:
+        int block;
+        bool ready;
+        uint8_t *data;
+    };
+    DecodedBlock *findDecodedBlock(int block) {
+        for (auto &b : m_decodedBlocks) {
+            if (b.block == block && b.ready) {
+                return &b;
+            }
+        }
+        return nullptr;
+    }
+    bool haveDecodedBlock(int block) const {
+        for (auto &b : m_decodedBlocks) {
+            if (b.block == block) {
+                return true;
+            }
+        }
+        return false;
+    }
+    DecodedBlock m_decodedBlocks[2];
+    std::thread *m_decodeThread;
+    std::mutex m_decodeLock;
+    std::condition_variable m_decodeSignal;
+    std::condition_variable m_decodedSignal;
+    volatile bool m_stopDecoding;
+    int m_requestedBlock;
+
+    // large blocks are decoded into a window of the last few frames
+    std::vector<uint8_t> m_window;
+    std::vector<uint8_t> m_windowIn;
+    uint32_t m_windowBlock;
+    uint32_t m_windowNext;
+    uint64_t m_windowReadPos;
+    uint64_t m_windowInPos;
+    uint64_t m_windowInLen;
+
+    // striped files, the stripes that intersect the ranges being read
+    std::vector<bool> m_neededStripes;
+    // where each needed stripe goes in the decoded blocks
+    std::vector<uint32_t> m_stripeSlots;
+    // buffered blocks being compressed and waiting to be written
+    CompressJob *m_curJob;
+    std::list<CompressJob*> m_compressQueue;
+    std::list<CompressJob*> m_compressJobs;
+    std::vector<std::thread*> m_compressThreads;
+    std::mutex m_compressLock;
+    std::condition_variable m_compressSignal;
+    std::condition_variable m_compressedSignal;
+    bool m_stopCompressing;
+    // m_xorFrames, buffers for building the delta frames
+    std::vector<uint8_t> m_lastFrame;
+    std::vector<uint8_t> m_curFrame;
+    std::vector<uint8_t> m_deltaFrame;
 };
 
 #ifndef NO_ZSTD
@@ -750,86 +1811,68 @@ class V2ZSTDCompressionHandler : public V2CompressedHandler {
 public:
     V2ZSTDCompressionHandler(V2FSEQFile *f) : V2CompressedHandler(f),
     m_cctx(nullptr),
-    m_dctx(nullptr)
+    m_dctx(nullptr),
+    m_windowDctx(nullptr)
     {
         m_outBuffer.pos = 0;
         m_outBuffer.size = V2FSEQ_OUT_BUFFER_SIZE;
         m_outBuffer.dst = malloc(m_outBuffer.size);
-        m_inBuffer.src = nullptr;
-        m_inBuffer.size = 0;
-        m_inBuffer.pos = 0;
     }
     virtual ~V2ZSTDCompressionHandler() {
+        stopDecodeThread();
+        stopCompressThreads();
         free(m_outBuffer.dst);
-        if (m_inBuffer.src != nullptr) {
-            free((void*)m_inBuffer.src);
-        }
-        if (m_dctx) {
+        if (m_cctx) {
             ZSTD_freeCStream(m_cctx);
         }
         if (m_dctx) {
             ZSTD_freeDStream(m_dctx);
         }
+        if (m_windowDctx) {
+            ZSTD_freeDStream(m_windowDctx);
+        }
     }
     virtual uint8_t getCompressionType() override { return 1;}
 
-    virtual FrameData *getFrame(uint32_t frame) override {
-        if (m_curBlock > 256 || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
-            //frame is not in the current block
-            m_curBlock = 0;
-            while (frame >= m_file->m_frameOffsets[m_curBlock + 1].first) {
-                m_curBlock++;
-            }
-            if (m_dctx == nullptr) {
-                m_dctx = ZSTD_createDStream();
-            }
-            ZSTD_initDStream(m_dctx);
-            seek(m_file->m_frameOffsets[m_curBlock].second, SEEK_SET);
-
-            uint64_t len = m_file->m_frameOffsets[m_curBlock + 1].second;
-            len -= m_file->m_frameOffsets[m_curBlock].second;
-            if (m_inBuffer.src) {
-                free((void*)m_inBuffer.src);
-            }
-            m_inBuffer.src = malloc(len);
-            m_inBuffer.pos = 0;
-            m_inBuffer.size = len;
-            int bread = read((void*)m_inBuffer.src, len);
-            if (bread != len) {
-                LogErr(VB_SEQUENCE, "Failed to read channel data for frame %d!   Needed to read %" PRIu64 " but read %d\n", frame, len, (int)bread);
-            }
-
-            if (m_curBlock < m_file->m_frameOffsets.size() - 2) {
-                //let the kernel know that we'll likely need the next block in the near future
-                uint64_t len2 = m_file->m_frameOffsets[m_curBlock + 2].second;
-                len2 -= m_file->m_frameOffsets[m_curBlock+1].second;
-                preload(tell(), len2);
-            }
+    virtual bool supportsWindowDecode() const override { return true; }
+    virtual void startWindowDecode() override {
+        //separate context as the decode thread may be using m_dctx
+        if (m_windowDctx == nullptr) {
+            m_windowDctx = ZSTD_createDStream();
+        }
+        ZSTD_initDStream(m_windowDctx);
+    }
+    virtual uint64_t decompressWindow(const uint8_t *in, uint64_t inSize, uint64_t &inUsed, uint8_t *out, uint64_t outSize) override {
+        ZSTD_inBuffer_s input = { in, inSize, 0 };
+        ZSTD_outBuffer_s output = { out, outSize, 0 };
+        size_t ret = ZSTD_decompressStream(m_windowDctx, &output, &input);
+        if (ZSTD_isError(ret)) {
+            LogErr(VB_SEQUENCE, "Error decompressing zstd block: %s\n", ZSTD_getErrorName(ret));
+            inUsed = inSize;
+            return 0;
+        }
+        inUsed = input.pos;
+        return output.pos;
+    }
 
-            free(m_outBuffer.dst);
-            int numFrames = (m_file->m_frameOffsets[m_curBlock + 1].first > m_file->getNumFrames() ? m_file->getNumFrames() :  m_file->m_frameOffsets[m_curBlock + 1].first) - m_file->m_frameOffsets[m_curBlock].first;
-            m_outBuffer.size = numFrames * m_file->getChannelCount();
-            m_outBuffer.dst = malloc(m_outBuffer.size);
-            m_outBuffer.pos = 0;
-            ZSTD_decompressStream(m_dctx, &m_outBuffer, &m_inBuffer);
+    virtual uint64_t decompressBlock(uint8_t *in, uint64_t inSize, uint8_t *out, uint64_t outSize) override {
+        if (m_dctx == nullptr) {
+            m_dctx = ZSTD_createDStream();
         }
-        int fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
-        fidx *= m_file->getChannelCount();
-        uint8_t *fdata = (uint8_t*)m_outBuffer.dst;
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
-        if (!m_file->m_sparseRanges.empty()) {
-            memcpy(data->m_data, &fdata[fidx], m_file->getChannelCount());
-        } else {
-            uint32_t sz = 0;
-            //read the ranges into the buffer
-            for (auto &rng : data->m_ranges) {
-                if (rng.first < m_file->getChannelCount()) {
-                    memcpy(&data->m_data[sz], &fdata[fidx + rng.first], rng.second);
-                    sz += rng.second;
-                }
+        ZSTD_initDStream(m_dctx);
+        ZSTD_inBuffer_s input = { in, inSize, 0 };
+        ZSTD_outBuffer_s output = { out, outSize, 0 };
+        while (input.pos < input.size && output.pos < output.size) {
+            size_t ret = ZSTD_decompressStream(m_dctx, &output, &input);
+            if (ZSTD_isError(ret)) {
+                LogErr(VB_SEQUENCE, "Error decompressing zstd block: %s\n", ZSTD_getErrorName(ret));
+                break;
+            }
+            if (ret == 0) {
+                break;
             }
         }
-        return data;
+        return output.pos;
     }
     void compressData(ZSTD_CStream* m_cctx, ZSTD_inBuffer_s &input, ZSTD_outBuffer_s &output) {
         ZSTD_compressStream(m_cctx, &output, &input);
@@ -850,7 +1893,40 @@ public:
             count += input.pos;
         }
     }
+    int getCompressionLevel() const {
+        int clevel = m_file->m_compressionLevel == -1 ? 10 : m_file->m_compressionLevel;
+        if (clevel < 0 || clevel > 25) {
+            clevel = 10;
+        }
+        return clevel;
+    }
+    virtual void compressToBuffer(const uint8_t *data, uint64_t len, std::vector<uint8_t> &out) override {
+        //uses its own stream so several blocks can be compressed at once
+        ZSTD_CStream *cctx = ZSTD_createCStream();
+        ZSTD_initCStream(cctx, getCompressionLevel());
+        out.resize(ZSTD_compressBound(len));
+        ZSTD_inBuffer_s input = { data, len, 0 };
+        ZSTD_outBuffer_s output = { &out[0], out.size(), 0 };
+        size_t ret = 0;
+        while (input.pos < input.size && !ZSTD_isError(ret)) {
+            ret = ZSTD_compressStream(cctx, &output, &input);
+        }
+        while ((ret = ZSTD_endStream(cctx, &output)) > 0 && !ZSTD_isError(ret)) {
+            out.resize(out.size() + ZSTD_CStreamOutSize());
+            output.dst = &out[0];
+            output.size = out.size();
+        }
+        if (ZSTD_isError(ret)) {
+            LogErr(VB_SEQUENCE, "Error compressing zstd block: %s\n", ZSTD_getErrorName(ret));
+        }
+        out.resize(output.pos);
+        ZSTD_freeCStream(cctx);
+    }
     virtual void addFrame(uint32_t frame, const uint8_t *data) override {
+        if (useBlockBuffer()) {
+            addBufferedFrame(frame, data);
+            return;
+        }
 
         if (m_cctx == nullptr) {
             m_cctx = ZSTD_createCStream();
@@ -858,15 +1934,18 @@ public:
         if (m_curFrameInBlock == 0) {
             uint64_t offset = tell();
             m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(frame, offset));
-            int clevel = m_file->m_compressionLevel == -1 ? 10 : m_file->m_compressionLevel;
-            if (clevel < 0 || clevel > 25) {
-                clevel = 10;
-            }
-            ZSTD_initCStream(m_cctx, clevel);
+            ZSTD_initCStream(m_cctx, getCompressionLevel());
         }
 
         uint8_t *curData = (uint8_t *)data;
-        if (m_file->m_sparseRanges.empty()) {
+        if (m_file->m_xorFrames) {
+            ZSTD_inBuffer_s input = {
+                deltaFrame(data),
+                m_file->getChannelCount(),
+                0
+            };
+            compressData(m_cctx, input, m_outBuffer);
+        } else if (m_file->m_sparseRanges.empty()) {
             ZSTD_inBuffer_s input = {
                 curData,
                 m_file->getChannelCount(),
@@ -891,11 +1970,7 @@ public:
         }
 
         m_curFrameInBlock++;
-        //if we hit the max per block OR we're in the first block and hit frame #10
-        //we'll start a new block.  We want the first block to be small so startup is
-        //quicker and we can get the first few frames as fast as possible.
-        if ((m_curBlock == 0 && m_curFrameInBlock == 10)
-            || (m_curFrameInBlock == m_framesPerBlock && m_file->m_frameOffsets.size() < m_maxBlocks)) {
+        if (isBlockFull()) {
             while(ZSTD_endStream(m_cctx, &m_outBuffer) > 0) {
                 write(m_outBuffer.dst, m_outBuffer.pos);
                 m_outBuffer.pos = 0;
@@ -907,7 +1982,9 @@ public:
         }
     }
     virtual void finalize() override {
-        if (m_curFrameInBlock) {
+        if (useBlockBuffer()) {
+            finishBufferedBlocks();
+        } else if (m_curFrameInBlock) {
             while(ZSTD_endStream(m_cctx, &m_outBuffer) > 0) {
                 write(m_outBuffer.dst, m_outBuffer.pos);
                 m_outBuffer.pos = 0;
@@ -922,117 +1999,204 @@ public:
 
     ZSTD_CStream* m_cctx;
     ZSTD_DStream* m_dctx;
+    ZSTD_DStream* m_windowDctx;
     ZSTD_outBuffer_s m_outBuffer;
-    ZSTD_inBuffer_s m_inBuffer;
+};
+#endif
+
+#ifndef NO_LZ4
+// LZ4 trades some file size for much faster decompression on low end
+// players.  There's no streaming API, each block (or stripe) is a single
+// LZ4 block so frames are always buffered.
+class V2LZ4CompressionHandler : public V2CompressedHandler {
+public:
+    V2LZ4CompressionHandler(V2FSEQFile *f) : V2CompressedHandler(f) {
+    }
+    virtual ~V2LZ4CompressionHandler() {
+        stopDecodeThread();
+        stopCompressThreads();
+    }
+    virtual uint8_t getCompressionType() override { return 3; }
+    virtual bool useBlockBuffer() const override { return true; }
+
+    virtual uint64_t decompressBlock(uint8_t *in, uint64_t inSize, uint8_t *out, uint64_t outSize) override {
+        int ret = LZ4_decompress_safe((const char*)in, (char*)out, inSize, outSize);
+        if (ret < 0) {
+            LogErr(VB_SEQUENCE, "Error decompressing lz4 block: %d\n", ret);
+            return 0;
+        }
+        return ret;
+    }
+    //-1 or 0-2 use the fast compressor, 3-12 use the high compression
+    //compressor which is slower to write but decompresses just as fast
+    int getCompressionLevel() const {
+        int clevel = m_file->m_compressionLevel;
+        if (clevel > LZ4HC_CLEVEL_MAX) {
+            clevel = LZ4HC_CLEVEL_MAX;
+        }
+        return clevel;
+    }
+    virtual void compressToBuffer(const uint8_t *data, uint64_t len, std::vector<uint8_t> &out) override {
+        out.resize(LZ4_compressBound(len));
+        int ret;
+        if (getCompressionLevel() >= LZ4HC_CLEVEL_MIN) {
+            ret = LZ4_compress_HC((const char*)data, (char*)&out[0], len, out.size(), getCompressionLevel());
+        } else {
+            ret = LZ4_compress_default((const char*)data, (char*)&out[0], len, out.size());
+        }
+        if (ret <= 0) {
+            LogErr(VB_SEQUENCE, "Error compressing lz4 block: %d\n", ret);
+            ret = 0;
+        }
+        out.resize(ret);
+    }
+    virtual void addFrame(uint32_t frame, const uint8_t *data) override {
+        addBufferedFrame(frame, data);
+    }
+    virtual void finalize() override {
+        finishBufferedBlocks();
+        V2CompressedHandler::finalize();
+    }
 };
 #endif
 
 #ifndef NO_ZLIB
 class V2ZLIBCompressionHandler : public V2CompressedHandler {
 public:
-    V2ZLIBCompressionHandler(V2FSEQFile *f) : V2CompressedHandler(f), m_stream(nullptr), m_outBuffer(nullptr), m_inBuffer(nullptr) {
+    V2ZLIBCompressionHandler(V2FSEQFile *f) : V2CompressedHandler(f), m_stream(nullptr), m_outBuffer(nullptr),
+        m_inflateStream(nullptr), m_windowStream(nullptr) {
     }
     virtual ~V2ZLIBCompressionHandler() {
+        stopDecodeThread();
+        stopCompressThreads();
         if (m_outBuffer) {
             free(m_outBuffer);
         }
-        if (m_inBuffer) {
-            free(m_inBuffer);
+        if (m_inflateStream) {
+            inflateEnd(m_inflateStream);
+            free(m_inflateStream);
+        }
+        if (m_windowStream) {
+            inflateEnd(m_windowStream);
+            free(m_windowStream);
         }
     }
     virtual uint8_t getCompressionType() override { return 2; }
 
+    virtual bool supportsWindowDecode() const override { return true; }
+    virtual void startWindowDecode() override {
+        //separate stream as the decode thread may be using m_inflateStream
+        if (m_windowStream == nullptr) {
+            m_windowStream = (z_stream*)calloc(1, sizeof(z_stream));
+            inflateInit(m_windowStream);
+        } else {
+            inflateReset(m_windowStream);
+        }
+    }
+    virtual uint64_t decompressWindow(const uint8_t *in, uint64_t inSize, uint64_t &inUsed, uint8_t *out, uint64_t outSize) override {
+        m_windowStream->next_in = (uint8_t*)in;
+        m_windowStream->avail_in = inSize;
+        m_windowStream->next_out = out;
+        m_windowStream->avail_out = outSize;
+        int ret = inflate(m_windowStream, Z_NO_FLUSH);
+        inUsed = inSize - m_windowStream->avail_in;
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            LogErr(VB_SEQUENCE, "Error decompressing zlib block: %d\n", ret);
+            inUsed = inSize;
+            return 0;
+        }
+        return outSize - m_windowStream->avail_out;
+    }
 
-    virtual FrameData *getFrame(uint32_t frame) override {
-        if (m_curBlock > 256 || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
-            //frame is not in the current block
-            m_curBlock = 0;
-            while (frame >= m_file->m_frameOffsets[m_curBlock + 1].first) {
-                m_curBlock++;
-            }
-            seek(m_file->m_frameOffsets[m_curBlock].second, SEEK_SET);
-            uint64_t len = m_file->m_frameOffsets[m_curBlock + 1].second;
-            len -= m_file->m_frameOffsets[m_curBlock].second;
-            if (m_inBuffer) {
-                free(m_inBuffer);
-            }
-            m_inBuffer = (uint8_t*)malloc(len);
-
-            int bread = read((void*)m_inBuffer, len);
-            if (bread != len) {
-                LogErr(VB_SEQUENCE, "Failed to read channel data for frame %d!   Needed to read %" PRIu64 " but read %d\n", frame, len, (int)bread);
-            }
-
-            if (m_curBlock < m_file->m_frameOffsets.size() - 2) {
-                //let the kernel know that we'll likely need the next block in the near future
-                uint64_t len = m_file->m_frameOffsets[m_curBlock + 2].second;
-                len -= m_file->m_frameOffsets[m_curBlock+1].second;
-                preload(tell(), len);
-            }
-
-            if (m_stream == nullptr) {
-                m_stream = (z_stream*)calloc(1, sizeof(z_stream));
-                m_stream->next_in = m_inBuffer;
-                m_stream->avail_in = len;
-                inflateInit(m_stream);
-            }
-            if (m_outBuffer != nullptr) {
-                free(m_outBuffer);
-            }
-            int numFrames = (m_file->m_frameOffsets[m_curBlock + 1].first > m_file->getNumFrames() ? m_file->getNumFrames() :  m_file->m_frameOffsets[m_curBlock + 1].first) - m_file->m_frameOffsets[m_curBlock].first;
-            int outsize = numFrames * m_file->getChannelCount();
-            m_outBuffer = (uint8_t*)malloc(outsize);
-            m_stream->next_out = m_outBuffer;
-            m_stream->avail_out = outsize;
 
-            inflate(m_stream, Z_SYNC_FLUSH);
-            inflateEnd(m_stream);
-            free(m_stream);
-            m_stream = nullptr;
-        }
-        int fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
-        fidx *= m_file->getChannelCount();
-        uint8_t *fdata = (uint8_t*)m_outBuffer;
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
-        if (!m_file->m_sparseRanges.empty()) {
-            memcpy(data->m_data, &fdata[fidx], m_file->getChannelCount());
+    virtual uint64_t decompressBlock(uint8_t *in, uint64_t inSize, uint8_t *out, uint64_t outSize) override {
+        if (m_inflateStream == nullptr) {
+            m_inflateStream = (z_stream*)calloc(1, sizeof(z_stream));
+            inflateInit(m_inflateStream);
         } else {
-            uint32_t sz = 0;
-            //read the ranges into the buffer
-            for (auto &rng : data->m_ranges) {
-                if (rng.first < m_file->getChannelCount()) {
-                    memcpy(&data->m_data[sz], &fdata[fidx + rng.first], rng.second);
-                    sz += rng.second;
-                }
-            }
+            inflateReset(m_inflateStream);
         }
-        return data;
+        m_inflateStream->next_in = in;
+        m_inflateStream->avail_in = inSize;
+        m_inflateStream->next_out = out;
+        m_inflateStream->avail_out = outSize;
+        int ret = Z_OK;
+        while (ret == Z_OK && m_inflateStream->avail_in && m_inflateStream->avail_out) {
+            ret = inflate(m_inflateStream, Z_NO_FLUSH);
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            LogErr(VB_SEQUENCE, "Error decompressing zlib block: %d\n", ret);
+        }
+        return outSize - m_inflateStream->avail_out;
     }
-    virtual void addFrame(uint32_t frame, const uint8_t *data) override {
+    int getCompressionLevel() const {
+        int clevel = m_file->m_compressionLevel == -1 ? 3 : m_file->m_compressionLevel;
+        if (clevel < 0 || clevel > 9) {
+            clevel = 3;
+        }
+        return clevel;
+    }
+    void startStream() {
         if (m_outBuffer == nullptr) {
             m_outBuffer = (uint8_t*)malloc(V2FSEQ_OUT_BUFFER_SIZE);
         }
         if (m_stream == nullptr) {
             m_stream = (z_stream*)calloc(1, sizeof(z_stream));
         }
+        deflateEnd(m_stream);
+        memset(m_stream, 0, sizeof(z_stream));
+        deflateInit(m_stream, getCompressionLevel());
+        m_stream->next_out = m_outBuffer;
+        m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
+    }
+    void finishStream() {
+        while (deflate(m_stream, Z_FINISH) != Z_STREAM_END) {
+            uint64_t sz = V2FSEQ_OUT_BUFFER_SIZE;
+            sz -= m_stream->avail_out;
+            write(m_outBuffer, sz);
+            m_stream->next_out = m_outBuffer;
+            m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
+        }
+        uint64_t sz = V2FSEQ_OUT_BUFFER_SIZE;
+        sz -= m_stream->avail_out;
+        write(m_outBuffer, sz);
+        m_stream->next_out = m_outBuffer;
+        m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
+    }
+    virtual void compressToBuffer(const uint8_t *data, uint64_t len, std::vector<uint8_t> &out) override {
+        //uses its own stream so several blocks can be compressed at once
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        deflateInit(&stream, getCompressionLevel());
+        out.resize(deflateBound(&stream, len));
+        stream.next_in = (uint8_t*)data;
+        stream.avail_in = len;
+        stream.next_out = &out[0];
+        stream.avail_out = out.size();
+        int ret = deflate(&stream, Z_FINISH);
+        if (ret != Z_STREAM_END) {
+            LogErr(VB_SEQUENCE, "Error compressing zlib block: %d\n", ret);
+        }
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+    }
+    virtual void addFrame(uint32_t frame, const uint8_t *data) override {
+        if (useBlockBuffer()) {
+            addBufferedFrame(frame, data);
+            return;
+        }
         if (m_curFrameInBlock == 0) {
             uint64_t offset = tell();
             m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(frame, offset));
-            deflateEnd(m_stream);
-            memset(m_stream, 0, sizeof(z_stream));
-        }
-        if (m_curFrameInBlock == 0) {
-            int clevel = m_file->m_compressionLevel == -1 ? 3 : m_file->m_compressionLevel;
-            if (clevel < 0 || clevel > 9) {
-                clevel = 3;
-            }
-            deflateInit(m_stream, clevel);
-            m_stream->next_out = m_outBuffer;
-            m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
+            startStream();
         }
 
         uint8_t *curData = (uint8_t *)data;
-        if (m_file->m_sparseRanges.empty()) {
+        if (m_file->m_xorFrames) {
+            m_stream->next_in = (uint8_t*)deltaFrame(data);
+            m_stream->avail_in = m_file->getChannelCount();
+            deflate(m_stream, 0);
+        } else if (m_file->m_sparseRanges.empty()) {
             m_stream->next_in = curData;
             m_stream->avail_in = m_file->getChannelCount();
             deflate(m_stream, 0);
@@ -1052,44 +2216,17 @@ public:
             m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
         }
         m_curFrameInBlock++;
-        //if we hit the max per block OR we're in the first block and hit frame #10
-        //we'll start a new block.  We want the first block to be small so startup is
-        //quicker and we can get the first few frames as fast as possible.
-        if ((m_curBlock == 0 && m_curFrameInBlock == 10)
-            || (m_curFrameInBlock == m_framesPerBlock && m_file->m_frameOffsets.size() < m_maxBlocks)) {
-
-            while (deflate(m_stream, Z_FINISH) != Z_STREAM_END) {
-                uint64_t sz = V2FSEQ_OUT_BUFFER_SIZE;
-                sz -= m_stream->avail_out;
-                write(m_outBuffer, sz);
-                m_stream->next_out = m_outBuffer;
-                m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
-            }
-            uint64_t sz = V2FSEQ_OUT_BUFFER_SIZE;
-            sz -= m_stream->avail_out;
-            write(m_outBuffer, sz);
-            m_stream->next_out = m_outBuffer;
-            m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
-
+        if (isBlockFull()) {
+            finishStream();
             m_curFrameInBlock = 0;
             m_curBlock++;
         }
     }
     virtual void finalize() override {
-        if (m_curFrameInBlock) {
-            while (deflate(m_stream, Z_FINISH) != Z_STREAM_END) {
-                uint64_t sz = V2FSEQ_OUT_BUFFER_SIZE;
-                sz -= m_stream->avail_out;
-                write(m_outBuffer, sz);
-                m_stream->next_out = m_outBuffer;
-                m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
-            }
-            uint64_t sz = V2FSEQ_OUT_BUFFER_SIZE;
-            sz -= m_stream->avail_out;
-            write(m_outBuffer, sz);
-            m_stream->next_out = m_outBuffer;
-            m_stream->avail_out = V2FSEQ_OUT_BUFFER_SIZE;
-
+        if (useBlockBuffer()) {
+            finishBufferedBlocks();
+        } else if (m_curFrameInBlock) {
+            finishStream();
             m_curFrameInBlock = 0;
             m_curBlock++;
         }
@@ -1098,7 +2235,8 @@ public:
 
     z_stream *m_stream;
     uint8_t *m_outBuffer;
-    uint8_t *m_inBuffer;
+    z_stream *m_inflateStream;
+    z_stream *m_windowStream;
 };
 #endif
 
@@ -1120,6 +2258,13 @@ void V2FSEQFile::createHandler() {
         LogErr(VB_ALL, "No support for zlib compression");
 #else
         m_handler = new V2ZLIBCompressionHandler(this);
+#endif
+        break;
+    case CompressionType::lz4:
+#ifdef NO_LZ4
+        LogErr(VB_ALL, "No support for lz4 compression");
+#else
+        m_handler = new V2LZ4CompressionHandler(this);
 #endif
         break;
     }
@@ -1132,6 +2277,10 @@ V2FSEQFile::V2FSEQFile(const std::string &fn, CompressionType ct, int cl)
     : FSEQFile(fn),
     m_compressionType(ct),
     m_compressionLevel(cl),
+    m_channelStripes(0),
+    m_xorFrames(false),
+    m_extendedBlockIndex(false),
+    m_compressionThreads(1),
     m_handler(nullptr)
 {
     m_seqVersionMajor = 2;
@@ -1152,6 +2301,22 @@ void V2FSEQFile::writeHeader() {
             m_seqChannelCount += a.second;
         }
     }
+    if (m_handler->getCompressionType() == 0) {
+        m_channelStripes = 0;
+        m_xorFrames = false;
+    } else if (m_channelStripes > m_seqChannelCount) {
+        m_channelStripes = 0;
+    } else if (m_channelStripes > 1) {
+        //the stripe count is a single byte and every block needs an index
+        //entry per stripe, leave room for at least a few blocks
+        m_channelStripes = std::min(m_channelStripes, (uint32_t)std::min(255, V2FSEQ_MAX_BLOCKS / V2FSEQ_MIN_INDEX_BLOCKS));
+        //don't leave empty stripes at the end
+        uint32_t w = getStripeWidth();
+        m_channelStripes = (m_seqChannelCount + w - 1) / w;
+    }
+    //2.0 players don't know about LZ4 either
+    m_seqVersionMinor = (m_channelStripes > 1 || m_xorFrames || m_extendedBlockIndex
+                         || m_compressionType == CompressionType::lz4) ? 1 : 0;
 
     uint8_t header[V2FSEQ_HEADER_SIZE];
     memset(header, 0, V2FSEQ_HEADER_SIZE);
@@ -1160,7 +2325,7 @@ void V2FSEQFile::writeHeader() {
     header[2] = 'E';
     header[3] = 'Q';
 
-    header[6] = 0; //minor
+    header[6] = m_seqVersionMinor; //minor
     header[7] = 2; //major
 
     // Step Size
@@ -1170,7 +2335,7 @@ void V2FSEQFile::writeHeader() {
     // Step time in ms
     header[18] = m_seqStepTime;
     //flags
-    header[19] = 0;
+    header[19] = m_xorFrames ? V2FSEQ_FLAG_XOR_FRAMES : 0;
 
     // compression type
     header[20] = m_handler->getCompressionType();
@@ -1178,8 +2343,8 @@ void V2FSEQFile::writeHeader() {
     header[21] = 0;
     //num ranges in sparse range index
     header[22] = m_sparseRanges.size();
-    //reserved for future use
-    header[23] = 0;
+    //number of channel stripes per compression block (0 if not striped, requires 2.1)
+    header[23] = m_channelStripes > 1 ? m_channelStripes : 0;
 
 
     //24-31 - timestamp/uuid/identifier
@@ -1189,8 +2354,11 @@ void V2FSEQFile::writeHeader() {
     memcpy(&header[24], &m_uniqueId, sizeof(m_uniqueId));
 
     // index size
-    uint32_t maxBlocks = m_handler->computeMaxBlocks() & 0xFF;
-    header[21] = maxBlocks;
+    uint32_t maxBlocks = m_handler->computeMaxBlocks() & V2FSEQ_MAX_BLOCKS;
+    header[21] = maxBlocks & 0xFF;
+    if (m_seqVersionMinor >= 1) {
+        header[20] |= (maxBlocks >> 4) & 0xF0;
+    }
 
     int headerSize = V2FSEQ_HEADER_SIZE + maxBlocks * 8 + m_sparseRanges.size() * 6;
 
@@ -1206,7 +2374,7 @@ void V2FSEQFile::writeHeader() {
     m_seqChanDataOffset = dataOffset;
 
     write(header, V2FSEQ_HEADER_SIZE);
-    for (int x = 0; x < maxBlocks; x++) {
+    for (uint32_t x = 0; x < maxBlocks; x++) {
         uint8_t buf[8] = {0, 0, 0, 0, 0, 0, 0, 0};
         //frame number and len
         write(buf, 8);
@@ -1239,6 +2407,10 @@ void V2FSEQFile::writeHeader() {
 V2FSEQFile::V2FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header)
 : FSEQFile(fn, file, header),
 m_compressionType(none),
+m_channelStripes(0),
+m_xorFrames(false),
+m_extendedBlockIndex(false),
+m_compressionThreads(1),
 m_handler(nullptr)
 {
     if (header[0] == 'E') {
@@ -1253,7 +2425,7 @@ m_handler(nullptr)
         uint64_t *a = (uint64_t*)&header[24];
         m_uniqueId = *a;
         
-        switch (header[20]) {
+        switch (header[20] & 0x0F) {
             case 0:
             m_compressionType = CompressionType::none;
             break;
@@ -1263,21 +2435,39 @@ m_handler(nullptr)
             case 2:
             m_compressionType = CompressionType::zlib;
             break;
+            case 3:
+            m_compressionType = CompressionType::lz4;
+            break;
             default:
-            LogErr(VB_SEQUENCE, "Unknown compression type: %d", (int)header[32]);
+            LogErr(VB_SEQUENCE, "Unknown compression type: %d", (int)(header[20] & 0x0F));
         }
         
         uint32_t maxBlocks = header[21];
+        if (m_seqVersionMinor >= 1) {
+            maxBlocks |= (header[20] & 0xF0) << 4;
+        }
+        if (m_seqVersionMinor >= 1 && header[23] > 1) {
+            //each block is split into stripes with an index entry per stripe
+            m_channelStripes = header[23];
+        }
+        if (m_seqVersionMinor >= 1 && m_compressionType != CompressionType::none) {
+            m_xorFrames = (header[19] & V2FSEQ_FLAG_XOR_FRAMES) != 0;
+        }
         
         uint64_t offset = m_seqChanDataOffset;
         int hoffset = V2FSEQ_HEADER_SIZE;
-        for (int x = 0; x < maxBlocks; x++) {
+        for (uint32_t x = 0; x < maxBlocks; x++) {
             int frame = read4ByteUInt(&header[hoffset]);
             hoffset += 4;
             uint64_t dlen = read4ByteUInt(&header[hoffset]);
             hoffset += 4;
             if (dlen > 0) {
-                m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(frame, offset));
+                if (m_channelStripes <= 1 || (m_stripeOffsets.size() % m_channelStripes) == 0) {
+                    m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(frame, offset));
+                }
+                if (m_channelStripes > 1) {
+                    m_stripeOffsets.push_back(offset);
+                }
                 offset += dlen;
             }
             if (x == 0) {
@@ -1287,6 +2477,9 @@ m_handler(nullptr)
         }
         
         m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(99999999, offset));
+        if (m_channelStripes > 1) {
+            m_stripeOffsets.push_back(offset);
+        }
         //sparse ranges
         for (int x = 0; x < header[22]; x++) {
             uint32_t st = read3ByteUInt(&header[hoffset]);
@@ -1304,6 +2497,13 @@ V2FSEQFile::~V2FSEQFile() {
         delete m_handler;
     }
 }
+bool V2FSEQFile::mapFile() {
+    if (m_compressionType != CompressionType::none) {
+        //compressed blocks are decompressed into their own buffers anyway
+        return false;
+    }
+    return FSEQFile::mapFile();
+}
 void V2FSEQFile::dumpInfo(bool indent) {
     FSEQFile::dumpInfo(indent);
     char ind[5] = "    ";
@@ -1314,6 +2514,8 @@ void V2FSEQFile::dumpInfo(bool indent) {
     LogDebug(VB_SEQUENCE, "%sSequence File Information\n", ind);
     LogDebug(VB_SEQUENCE, "%scompressionType       : %d\n", ind, m_compressionType);
     LogDebug(VB_SEQUENCE, "%snumBlocks             : %d\n", ind, m_handler->computeMaxBlocks());
+    LogDebug(VB_SEQUENCE, "%schannelStripes        : %d\n", ind, m_channelStripes);
+    LogDebug(VB_SEQUENCE, "%sxorFrames             : %d\n", ind, m_xorFrames);
     for (auto &a : m_frameOffsets) {
         LogDebug(VB_SEQUENCE, "%s      %d              : %" PRIu64 "\n", ind, a.first, a.second);
     }
@@ -1325,24 +2527,28 @@ void V2FSEQFile::dumpInfo(bool indent) {
 
 
 void V2FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) {
+    //the channels needed, as offsets into the (possibly sparse) frame data
+    std::vector<std::pair<uint32_t, uint32_t>> packedRanges;
     if (m_sparseRanges.empty()) {
         m_rangesToRead = ranges;
-        m_dataBlockSize = 0;
-        for (auto &rng : m_rangesToRead) {
-            //make sure we don't read beyond the end of the sequence data
-            int toRead = rng.second;
-            if ((rng.first + toRead) > m_seqChannelCount) {
-                toRead = m_seqChannelCount - rng.first;
-                rng.second = toRead;
-            }
-            m_dataBlockSize += toRead;
-        }
+        m_dataBlockSize = clipReadRanges(m_rangesToRead, m_seqChannelCount);
+        packedRanges = m_rangesToRead;
     } else if (m_compressionType != CompressionType::none) {
-        //with compression, there is no way to NOT read the entire frame of data, we'll just
-        //use the sparse data range since we'll have everything anyway so the ranges
-        //needed is relatively irrelevant
+        //with compression, we return the entire sparse frame, but if the file is
+        //striped, only the stripes holding the needed channels are decompressed
         m_dataBlockSize = m_seqChannelCount;
         m_rangesToRead = m_sparseRanges;
+        uint32_t pos = 0;
+        for (auto &sp : m_sparseRanges) {
+            for (auto &rng : ranges) {
+                uint32_t start = std::max(rng.first, sp.first);
+                uint32_t end = std::min(rng.first + rng.second, sp.first + sp.second);
+                if (start < end) {
+                    packedRanges.push_back(std::pair<uint32_t, uint32_t>(pos + start - sp.first, end - start));
+                }
+            }
+            pos += sp.second;
+        }
     } else {
         //no compression with sparse ranges
         //FIXME - an intersection between the two would be useful, but hard
@@ -1351,6 +2557,10 @@ void V2FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &r
         m_dataBlockSize = m_seqChannelCount;
         m_rangesToRead = m_sparseRanges;
     }
+    if (m_handler != nullptr) {
+        m_handler->setChannelRanges(packedRanges);
+    }
+    setReadRanges(m_rangesToRead);
     FrameData *f = getFrame(0);
     if (f) {
         delete f;
@@ -1370,6 +2580,12 @@ FrameData *V2FSEQFile::getFrame(uint32_t frame) {
     }
     return nullptr;
 }
+bool V2FSEQFile::readFrameData(uint32_t frame, uint8_t *data) {
+    if (frame >= m_seqNumFrames || m_handler == nullptr) {
+        return false;
+    }
+    return m_handler->readFrameData(frame, data);
+}
 void V2FSEQFile::addFrame(uint32_t frame,
                           const uint8_t *data) {
     if (m_handler != nullptr) {
@@ -1381,9 +2597,23 @@ void V2FSEQFile::finalize() {
     if (m_handler != nullptr) {
         m_handler->finalize();
     }
+    //live recordings only know the real frame count once they are
+    //done so rewrite it in the header
+    uint64_t curr = tell();
+    uint8_t buf[4];
+    write4ByteUInt(buf, m_seqNumFrames);
+    seek(14, SEEK_SET);
+    write(buf, 4);
+    seek(curr, SEEK_SET);
     FSEQFile::finalize();
 }
 
+uint32_t V2FSEQFile::getStripeWidth() const {
+    if (m_channelStripes <= 1) {
+        return m_seqChannelCount;
+    }
+    return (m_seqChannelCount + m_channelStripes - 1) / m_channelStripes;
+}
 uint32_t V2FSEQFile::getMaxChannel() const {
     uint32_t ret = m_seqChannelCount;
     for (auto &a : m_sparseRanges) {
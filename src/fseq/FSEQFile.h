@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <memory>
 
 class FSEQFile {
 public:
@@ -30,11 +31,30 @@ public:
         
         uint32_t frame;
     };
+
+    typedef std::shared_ptr<const std::vector<std::pair<uint32_t, uint32_t>>> RangeList;
+
+    //Frame data stored as the packed ranges passed to prepareRead.  The
+    //buffer is owned by the caller so a player can keep a pool of these and
+    //refill them with fillFrame instead of allocating a frame each time.
+    //The frame shares the ranges so it stays valid after the file is
+    //prepared again or deleted.
+    class BufferFrameData : public FrameData {
+        public:
+        BufferFrameData(uint8_t *buf) : FrameData(0), m_data(buf) {};
+        virtual ~BufferFrameData() {};
+
+        virtual void readFrame(uint8_t *data) override;
+
+        uint8_t *m_data;
+        RangeList m_ranges;
+    };
     
     enum CompressionType {
         none,
         zstd,
-        zlib
+        zlib,
+        lz4
     };
 
 protected:
@@ -53,6 +73,11 @@ public:
                                     int version,
                                     CompressionType ct = CompressionType::zstd,
                                     int level = 10);
+
+    //Compressed blocks read from files are kept in a cache shared by all
+    //files, up to maxSize bytes, least recently used blocks are dropped
+    //first.  0 (the default) disables the cache.
+    static void setBlockCacheSize(uint64_t maxSize);
     //utility methods
     static std::string getMediaFilename(const std::string &fn);
     std::string getMediaFilename() const;
@@ -60,6 +85,17 @@ public:
 
     void parseVariableHeaders(const std::vector<uint8_t> &header, int start);
     
+    //Map the file into memory so frames from uncompressed files can be
+    //copied directly out of the page cache instead of read via stdio.
+    //Should be called before prepareRead.  Returns false if the file
+    //cannot be mapped, in which case the normal reads are used.  The file
+    //size is checked for each frame and the mapping is dropped if it
+    //shrank, but a frame already handed out can still SIGBUS if the file
+    //is truncated before it is copied, so sequences should be replaced by
+    //renaming a new file over them rather than rewritten in place.
+    virtual bool mapFile();
+    bool isMapped() const { return m_memoryMap != nullptr; }
+    
     
     //prepare to start reading. The ranges will be the list of channel ranges that
     //are acutally needed for each frame.   The reader can optimize to only
@@ -70,6 +106,15 @@ public:
     //provide the necessary data in a timely fassion for the given frame
     //It may not be used right away and will be deleted at some point in the future
     virtual FrameData *getFrame(uint32_t frame) = 0;
+
+    //Reads the frame into the frame's buffer which must be at least
+    //getDataBlockSize() bytes.  The frame must not be used after the
+    //FSEQFile is deleted or prepareRead is called again.
+    bool fillFrame(uint32_t frame, BufferFrameData *fd);
+    //Reads the packed ranges for the frame into data
+    virtual bool readFrameData(uint32_t frame, uint8_t *data) = 0;
+    //size of the buffer needed to hold the ranges for a frame, valid after prepareRead
+    uint32_t getDataBlockSize() const { return m_dataBlockSize; }
     
     //For writing to the fseq file
     virtual void initializeFromFSEQ(const FSEQFile& fseq);
@@ -97,8 +142,14 @@ public:
     
     const std::vector<uint8_t> &getMemoryBuffer() const { return m_memoryBuffer;}
     uint64_t getMemoryBufferPos() const { return m_memoryBufferPos; }
+
+    //The ranges to read and the data size needed to read the ranges
+    std::vector<std::pair<uint32_t, uint32_t>> m_rangesToRead;
+    uint32_t m_dataBlockSize;
 protected:
     std::string   m_filename;
+    //identifies this version of the file in the block cache
+    std::string   m_cacheKey;
     uint64_t      m_uniqueId;
     uint32_t      m_seqNumFrames;
     uint32_t      m_seqChannelCount;
@@ -116,10 +167,34 @@ protected:
     uint64_t tell();
     uint64_t write(const void * ptr, uint64_t size);
     uint64_t read(void *ptr, uint64_t size);
+    //read from the given position without using/changing the current file
+    //position so it can be used from a background thread
+    uint64_t readAt(void *ptr, uint64_t size, uint64_t pos);
     void preload(uint64_t pos, uint64_t size);
+    //readAt through the block cache, for compressed blocks that are read
+    //whole each time the file is played
+    uint64_t readCachedAt(void *ptr, uint64_t size, uint64_t pos);
+    bool isCached(uint64_t pos, uint64_t size);
+
+    class MemoryMap;
+    //the ranges handed out with frames, frames that are still out there
+    //keep the old ranges
+    void setReadRanges(const std::vector<std::pair<uint32_t, uint32_t>> &ranges);
+    //returns a frame that reads directly from the mapping or nullptr if the
+    //file is not mapped.  If packed is true, the ranges are stored back to
+    //back in the file instead of at their channel offsets
+    FrameData *getMappedFrame(uint32_t frame, uint64_t offset, uint32_t size, bool packed);
+    bool readMappedFrameData(uint64_t offset, uint32_t size, bool packed, uint8_t *data);
+    //returns false, and drops the mapping, if the file was truncated
+    bool mappedReadAhead(uint64_t offset, uint32_t size);
     
 private:
     FILE* volatile  m_seqFile;
+    std::shared_ptr<MemoryMap> m_memoryMap;
+    RangeList     m_readRanges;
+    uint64_t      m_mappedReadAheadStart;
+    uint64_t      m_mappedReadAheadEnd;
+    friend class MappedFrameData;
     std::vector<uint8_t> m_memoryBuffer;
     uint64_t      m_memoryBufferPos;
 };
@@ -134,6 +209,7 @@ public:
   
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) override;
     virtual FrameData *getFrame(uint32_t frame) override;
+    virtual bool readFrameData(uint32_t frame, uint8_t *data) override;
 
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
@@ -141,11 +217,6 @@ public:
     virtual void finalize() override;
     
     virtual uint32_t getMaxChannel() const override;
-
-    
-    //The ranges to read and the data size needed to read the ranges
-    std::vector<std::pair<uint32_t, uint32_t>> m_rangesToRead;
-    uint32_t m_dataBlockSize;
 };
 
 
@@ -159,8 +230,10 @@ public:
 
     virtual ~V2FSEQFile();
     
+    virtual bool mapFile() override;
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges) override;
     virtual FrameData *getFrame(uint32_t frame) override;
+    virtual bool readFrameData(uint32_t frame, uint8_t *data) override;
     
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
@@ -171,13 +244,26 @@ public:
 
     virtual uint32_t getMaxChannel() const override;
 
+    uint32_t getStripeWidth() const;
+
     
     CompressionType m_compressionType;
     int             m_compressionLevel;
     std::vector<std::pair<uint32_t, uint32_t>> m_sparseRanges;
-    std::vector<std::pair<uint32_t, uint32_t>> m_rangesToRead;
     std::vector<std::pair<uint32_t, uint64_t>> m_frameOffsets;
-    uint32_t m_dataBlockSize;
+    //compressed blocks can be split into channel stripes that are compressed
+    //separately so readers only decompress the channels they need.
+    //0 or 1 if the blocks are not split
+    uint32_t        m_channelStripes;
+    std::vector<uint64_t> m_stripeOffsets;
+    //each frame in a compression block is XORed with the previous frame
+    //before compressing so unchanged channels compress down to runs of zeros
+    bool            m_xorFrames;
+    //allow up to 4095 compression blocks (2.1) so long sequences keep
+    //short blocks, 2.0 files are limited to 255
+    bool            m_extendedBlockIndex;
+    //number of threads used to compress blocks when writing
+    int             m_compressionThreads;
 private:
     
     void createHandler();
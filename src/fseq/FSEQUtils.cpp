@@ -4,6 +4,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <string>
+
 #include "fppversion.h"
 #include "log.h"
 
@@ -17,19 +19,32 @@ void usage(char *appname) {
     printf("   -v                - verbose\n");
     printf("   -o OUTPUTFILE     - Filename for Output FSEQ\n");
     printf("   -f #              - FSEQ Version\n");
-    printf("   -c (none|zstd|zlib) - Compession type\n");
+    printf("   -c (none|zstd|zlib|lz4) - Compession type (lz4 is v2.1)\n");
     printf("   -l #              - Compession level (-1 for default)\n");
+    printf("   -s #              - Split compressed blocks into # channel stripes so players\n");
+    printf("                            only decompress the channels they output (v2.1)\n");
+    printf("   -j #              - Number of threads to use for compression\n");
+    printf("   -x                - XOR each frame with the previous frame before compressing (v2.1)\n");
+    printf("   -b                - Allow more than 255 compression blocks for faster seeking (v2.1)\n");
     printf("   -r (#-# | #+#)    - Channel Range.  Use - to separate start/end channel\n");
     printf("                            Use + to separate start channel + num channels\n");
+    printf("                            Separate several ranges with commas\n");
+    printf("   -H HOSTNAME       - Name the output FileName-HOSTNAME.fseq so a remote with that\n");
+    printf("                            hostname plays it instead of FileName.fseq\n");
     printf("   -n                - No Sparse. -r will only read the range, but the resulting fseq is not sparse.\n");
     printf("   -h                - This help output\n");
 }
 const char *outputFilename = nullptr;
+static const char *hostname = nullptr;
 static int fseqVersion = 2;
 static int compressionLevel = -1;
 static bool verbose = false;
 static std::vector<std::pair<uint32_t, uint32_t>> ranges;
 static bool sparse = true;
+static int channelStripes = 0;
+static bool xorFrames = false;
+static bool extendedBlockIndex = false;
+static int compressionThreads = 1;
 static V2FSEQFile::CompressionType compressionType = V2FSEQFile::CompressionType::zstd;
 
 int parseArguments(int argc, char **argv) {
@@ -46,7 +61,7 @@ int parseArguments(int argc, char **argv) {
             {0,                0,                    0, 0}
         };
         
-        c = getopt_long(argc, argv, "c:l:o:f:r:hVvn", long_options, &option_index);
+        c = getopt_long(argc, argv, "c:l:o:f:r:s:j:H:hVvnxb", long_options, &option_index);
         if (c == -1) {
             break;
         }
@@ -54,17 +69,27 @@ int parseArguments(int argc, char **argv) {
         switch (c) {
             case 'r': {
                     char *end = optarg;
-                    int startc = strtol(optarg, &end, 10);
-                    int r = *end == '-';
-                    end++;
-                    int endc = strtol(end, &end, 10);
-                    if (r) {
-                        ranges.push_back(std::pair<uint32_t, uint32_t>(startc, endc-startc+1));
-                    } else {
-                        ranges.push_back(std::pair<uint32_t, uint32_t>(startc, endc));
+                    while (*end) {
+                        int startc = strtol(end, &end, 10);
+                        int r = *end == '-';
+                        end++;
+                        int endc = strtol(end, &end, 10);
+                        if (r) {
+                            ranges.push_back(std::pair<uint32_t, uint32_t>(startc, endc-startc+1));
+                        } else {
+                            ranges.push_back(std::pair<uint32_t, uint32_t>(startc, endc));
+                        }
+                        if (*end == ',') {
+                            end++;
+                        } else {
+                            break;
+                        }
                     }
                 }
                 break;
+            case 'H':
+                hostname = optarg;
+                break;
             case 'v':
                 verbose = true;
                 break;
@@ -73,6 +98,8 @@ int parseArguments(int argc, char **argv) {
                     compressionType = V2FSEQFile::CompressionType::none;
                 } else if (strcmp(optarg, "zlib") == 0) {
                     compressionType = V2FSEQFile::CompressionType::zlib;
+                } else if (strcmp(optarg, "lz4") == 0) {
+                    compressionType = V2FSEQFile::CompressionType::lz4;
                 } else {
                     compressionType = V2FSEQFile::CompressionType::zstd;
                 }
@@ -80,6 +107,9 @@ int parseArguments(int argc, char **argv) {
             case 'l':
                 compressionLevel = strtol(optarg, NULL, 10);
                 break;
+            case 's':
+                channelStripes = strtol(optarg, NULL, 10);
+                break;
             case 'f':
                 fseqVersion = strtol(optarg, NULL, 10);
                 break;
@@ -89,6 +119,15 @@ int parseArguments(int argc, char **argv) {
             case 'n':
                 sparse = false;
                 break;
+            case 'j':
+                compressionThreads = strtol(optarg, NULL, 10);
+                break;
+            case 'x':
+                xorFrames = true;
+                break;
+            case 'b':
+                extendedBlockIndex = true;
+                break;
             case 'V':
                 printVersionInfo();
                 exit(0);
@@ -109,6 +148,22 @@ int main(int argc, char *argv[]) {
         SetLogLevel("debug");
     }
     FSEQFile *src = FSEQFile::openFSEQFile(argv[idx]);
+    std::string hostFilename;
+    if (hostname && !outputFilename) {
+        //same name CheckForHostSpecificFile looks for on the remote
+        hostFilename = argv[idx];
+        size_t dot = hostFilename.rfind('.');
+        if (dot == std::string::npos || hostFilename.find('/', dot) != std::string::npos) {
+            dot = hostFilename.length();
+        }
+        hostFilename.insert(dot, std::string("-") + hostname);
+        outputFilename = hostFilename.c_str();
+    }
+    if (src && !outputFilename) {
+        printf("No output file given, use -o or -H\n");
+        delete src;
+        src = nullptr;
+    }
     if (src) {
         
         FSEQFile *dest = FSEQFile::createFSEQFile(outputFilename,
@@ -121,6 +176,12 @@ int main(int argc, char *argv[]) {
             V2FSEQFile *f = (V2FSEQFile*)dest;
             f->m_sparseRanges = ranges;
         }
+        if (fseqVersion == 2) {
+            ((V2FSEQFile*)dest)->m_channelStripes = channelStripes;
+            ((V2FSEQFile*)dest)->m_xorFrames = xorFrames;
+            ((V2FSEQFile*)dest)->m_extendedBlockIndex = extendedBlockIndex;
+            ((V2FSEQFile*)dest)->m_compressionThreads = compressionThreads;
+        }
         src->prepareRead(ranges);
 
         dest->initializeFromFSEQ(*src);
@@ -36,6 +36,7 @@
 #include "MultiSync.h"
 #include "playlist/Playlist.h"
 #include "Scheduler.h"
+#include "SequenceLayer.h"
 #include "settings.h"
 
 #include <fstream>
@@ -127,7 +128,12 @@ const http_response PlayerResource::render_GET(const http_request &req)
 	LogDebug(VB_HTTP, "URL: %s %s\n", url.c_str(), req.get_querystring().c_str());
 
 	// Keep IF statement in alphabetical order
-	if (url == "effects")
+	if (url == "bridge/record")
+	{
+		result = Bridge_GetRecordingStatus();
+		SetOKResult(result, "");
+	}
+	else if (url == "effects")
 	{
 		GetRunningEffects(result);
 	}
@@ -184,6 +190,11 @@ const http_response PlayerResource::render_GET(const http_request &req)
 	{
 		LogDebug(VB_HTTP, "API - Getting list of running sequences\n");
 	}
+	else if (url == "sequences/layers")
+	{
+		result = GetSequenceLayers();
+		SetOKResult(result, "");
+	}
 	else if (url == "testing")
 	{
 		LogDebug(VB_HTTP, "API - Getting test mode status\n");
@@ -247,7 +258,25 @@ const http_response PlayerResource::render_POST(const http_request &req)
 	}
 
 	// Keep IF statement in alphabetical order
-	if (boost::starts_with(url, "effects/"))
+	if (boost::starts_with(url, "bridge/record/start/"))
+	{
+		boost::replace_first(url, "bridge/record/start/", "");
+		LogDebug(VB_HTTP, "API - Recording bridge data to '%s'\n", url.c_str());
+
+		if (Bridge_StartRecording(url))
+			SetOKResult(result, "Recording started");
+		else
+			SetErrorResult(result, 400, "Could not start recording");
+	}
+	else if (url == "bridge/record/stop")
+	{
+		LogDebug(VB_HTTP, "API - Stopping bridge recording\n");
+
+		Bridge_StopRecording();
+		result = Bridge_GetRecordingStatus();
+		SetOKResult(result, "Recording stopped");
+	}
+	else if (boost::starts_with(url, "effects/"))
 	{
 		boost::replace_first(url, "effects/", "");
 
@@ -352,7 +381,36 @@ const http_response PlayerResource::render_POST(const http_request &req)
 	{
 		boost::replace_first(url, "sequences/", "");
 
-		if (boost::ends_with(url, "/start"))
+		if (boost::ends_with(url, "/layer/stop"))
+		{
+			boost::replace_last(url, "/layer/stop", "");
+			LogDebug(VB_HTTP, "API - Stopping sequence layer '%s'\n", url.c_str());
+
+			if (StopSequenceLayer(url))
+				SetOKResult(result, "Sequence layer stopped");
+			else
+				SetErrorResult(result, 404, "Sequence layer not running");
+		}
+		else if (boost::ends_with(url, "/layer"))
+		{
+			// {"ranges": "1-1500,3001-3600", "loop": 1}, no ranges for
+			// the whole sequence
+			boost::replace_last(url, "/layer", "");
+			LogDebug(VB_HTTP, "API - Starting sequence layer '%s' w/ content '%s'\n",
+				url.c_str(), req.get_content().c_str());
+
+			std::vector<std::pair<uint32_t, uint32_t>> ranges;
+			if (data.isMember("ranges"))
+				ranges = ParseChannelRanges(data["ranges"].asString(), 1);
+
+			if (data.isMember("ranges") && ranges.empty())
+				SetErrorResult(result, 400, "Invalid channel ranges");
+			else if (StartSequenceLayer(url, ranges, data.isMember("loop") ? data["loop"].asInt() : 0))
+				SetOKResult(result, "Sequence layer started");
+			else
+				SetErrorResult(result, 400, "Could not start sequence layer");
+		}
+		else if (boost::ends_with(url, "/start"))
 		{
 			boost::replace_last(url, "/start", "");
 			LogDebug(VB_HTTP, "API - Starting sequence '%s'\n", url.c_str());
@@ -375,6 +433,22 @@ const http_response PlayerResource::render_POST(const http_request &req)
 		{
 			LogDebug(VB_HTTP, "API - Pausing sequence '%s'\n", url.c_str());
 		}
+		else if (boost::ends_with(url, "/sparse"))
+		{
+			boost::replace_last(url, "/sparse", "");
+			LogDebug(VB_HTTP, "API - Creating remote sparse copies of sequence '%s'\n", url.c_str());
+			if (url.empty() || (url.find('/') != std::string::npos) ||
+				(url.find("..") != std::string::npos))
+			{
+				SetErrorResult(result, 400, "Invalid sequence name");
+			}
+			else
+			{
+				// this can take a while for large sequences so don't hold up the request
+				multiSync->QueueRemoteSparseSequences(url);
+				SetOKResult(result, "Creating remote sequences");
+			}
+		}
 		else if (boost::ends_with(url, "/step"))
 		{
 			boost::replace_last(url, "/step", "");
@@ -637,7 +711,26 @@ void PlayerResource::GetCurrentStatus(Json::Value &result)
     sstr << std::put_time(&tm, "%a %b %d %H:%M:%S %Z %Y");
     std::string str = sstr.str();
     result["time"] = str;
-    
+    result["output_pipeline_latency"] = GetOutputPipelineLatency();
+
+    unsigned long frames, lateFrames, overruns;
+    int jitterAvg, jitterPeak;
+    GetChannelOutputTiming(frames, lateFrames, overruns, jitterAvg, jitterPeak);
+    Json::Value timing;
+    timing["frames"] = (Json::UInt64)frames;
+    timing["late_frames"] = (Json::UInt64)lateFrames;
+    timing["overruns"] = (Json::UInt64)overruns;
+    timing["jitter_avg"] = jitterAvg;
+    timing["jitter_peak"] = jitterPeak;
+    result["output_timing"] = timing;
+
+    unsigned long dataSent, dataSkipped;
+    GetUnchangedDataStats(dataSent, dataSkipped);
+    Json::Value unchanged;
+    unchanged["sent"] = (Json::UInt64)dataSent;
+    unchanged["skipped"] = (Json::UInt64)dataSkipped;
+    result["unchanged_data"] = unchanged;
+
     if (mode == 1) {
         //bridge mode only returns the base information
         return;
@@ -655,6 +748,10 @@ void PlayerResource::GetCurrentStatus(Json::Value &result)
     result["time_elapsed"] = "00:00";
     result["time_remaining"] = "00:00";
 
+    if (sequence->IsSequenceRunning()) {
+        sequence->GetReadAheadStatus(result["sequence_read_ahead"]);
+    }
+
     char NextPlaylist[128] = "No playlist scheduled.";
     char NextScheduleStartText[64] = "";
     scheduler->GetNextScheduleStartText(NextScheduleStartText);
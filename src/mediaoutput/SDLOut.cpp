@@ -54,6 +54,7 @@ extern "C"
 #include "common.h"
 #include "log.h"
 #include "MultiSync.h"
+#include "PlaybackThreads.h"
 #include "SDLOut.h"
 #include "Sequence.h"
 #include "settings.h"
@@ -511,6 +512,8 @@ bool SDL::initSDL()  {
 }
 
 void SDL::runDecode() {
+    SetupPlaybackThread("fppd_decode", PLAYBACK_THREAD_MEDIA);
+
     while (_state != SDLSTATE::SDLUNINITIALISED) {
         decoding = true;
         SDLInternalData *data = this->data;
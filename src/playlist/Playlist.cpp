@@ -44,6 +44,7 @@
 #include "log.h"
 #include "mqtt.h"
 #include "Playlist.h"
+#include "Sequence.h"
 #include "settings.h"
 
 #include "PlaylistEntryBoth.h"
@@ -390,6 +391,59 @@ void Playlist::SwitchToLeadOut(void)
 	m_leadOut[0]->StartPlaying();
 }
 
+/*
+ * The entry that will most likely play after the current one.  Jumps
+ * to other sections/items are not followed, if this guesses wrong the
+ * prepared entry is just not used.
+ */
+PlaylistEntryBase *Playlist::GetNextEntry(void)
+{
+	if ((FPPstatus == FPP_STATUS_STOPPING_GRACEFULLY) ||
+		(FPPstatus == FPP_STATUS_STOPPING_NOW))
+		return NULL;
+
+	if ((m_currentSection->at(m_sectionPosition)->GetNextSection() != "") ||
+		(m_currentSection->at(m_sectionPosition)->GetNextItem() != -1))
+		return NULL;
+
+	if ((m_sectionPosition + 1) < m_currentSection->size())
+		return m_currentSection->at(m_sectionPosition + 1);
+
+	if (m_currentSectionStr == "LeadIn")
+	{
+		if (m_mainPlaylist.size())
+			return m_mainPlaylist[0];
+		if (m_leadOut.size())
+			return m_leadOut[0];
+	}
+	else if (m_currentSectionStr == "MainPlaylist")
+	{
+		if ((m_repeat) && (!m_loopCount || ((m_loop + 1) < m_loopCount)) &&
+			(FPPstatus != FPP_STATUS_STOPPING_GRACEFULLY_AFTER_LOOP))
+			return m_mainPlaylist[0];
+		if (m_leadOut.size())
+			return m_leadOut[0];
+	}
+
+	return NULL;
+}
+
+/*
+ * Let the next sequence get a head start so there isn't a gap
+ * when switching to it
+ */
+void Playlist::PrepNextEntry(void)
+{
+	PlaylistEntryBase *next = GetNextEntry();
+
+	if (!next || next->IsPrepped())
+		return;
+
+	if ((next->GetType() == "sequence") ||
+		(next->GetType() == "both"))
+		next->Prep();
+}
+
 /*
  *
  */
@@ -513,6 +567,10 @@ int Playlist::StopGracefully(int forceStop, int afterCurrentLoop)
 	else
 		m_currentState = "stoppingGracefully";
 
+	// The next entry won't be started now, free anything prepared for it
+	if (!m_subPlaylist && sequence)
+		sequence->ReleasePreparedSequence();
+
 	m_forceStop = forceStop;
 
 	return 1;
@@ -567,8 +625,13 @@ int Playlist::Process(void)
 //	}
 
 	if (m_currentSection->at(m_sectionPosition)->IsPlaying())
+	{
 		m_currentSection->at(m_sectionPosition)->Process();
 
+		if (m_currentSection->at(m_sectionPosition)->IsPlaying())
+			PrepNextEntry();
+	}
+
 	if (m_currentSection->at(m_sectionPosition)->IsFinished())
 	{
 		LogDebug(VB_PLAYLIST, "Playlist entry finished\n");
@@ -752,6 +815,10 @@ void Playlist::SetIdle(void)
 	if (!m_subPlaylist)
 		FPPstatus = FPP_STATUS_IDLE;
 
+	// Nothing will use a sequence prepared for the next entry
+	if (!m_subPlaylist && sequence)
+		sequence->ReleasePreparedSequence();
+
 	m_currentState = "idle";
 	m_name = "";
 	m_desc = "";
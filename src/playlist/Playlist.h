@@ -140,6 +140,8 @@ class Playlist {
 	void               ReloadIfNeeded(void);
 	void               SwitchToMainPlaylist(void);
 	void               SwitchToLeadOut(void);
+	PlaylistEntryBase *GetNextEntry(void);
+	void               PrepNextEntry(void);
 
 	void                *m_parent;
 	std::string          m_filename;
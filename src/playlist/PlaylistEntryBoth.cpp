@@ -82,6 +82,8 @@ int PlaylistEntryBoth::StartPlaying(void)
 		return 0;
 	}
 
+	m_isPrepped = 0;
+
     if (m_mediaEntry && !m_mediaEntry->PreparePlay()) {
         delete m_mediaEntry;
 		m_mediaEntry = nullptr;
@@ -107,6 +109,16 @@ int PlaylistEntryBoth::StartPlaying(void)
 	return PlaylistEntryBase::StartPlaying();
 }
 
+/*
+ *
+ */
+int PlaylistEntryBoth::Prep(void)
+{
+	m_sequenceEntry->Prep();
+
+	return PlaylistEntryBase::Prep();
+}
+
 /*
  *
  */
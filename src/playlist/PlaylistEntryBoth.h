@@ -40,6 +40,7 @@ class PlaylistEntryBoth : public PlaylistEntryBase {
 	int  Init(Json::Value &config);
 
 	int  StartPlaying(void);
+	int  Prep(void);
 	int  Process(void);
 	int  Stop(void);
 
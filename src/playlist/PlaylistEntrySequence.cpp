@@ -82,6 +82,9 @@ int PlaylistEntrySequence::StartPlaying(void)
 //	if (!m_sequenceID)
 //		return 0;
 
+	// Uses the warm started file if Prep() was called
+	m_isPrepped = 0;
+
 	if (sequence->OpenSequenceFile(m_sequenceName.c_str(), 0) <= 0)
 	{
 		LogErr(VB_PLAYLIST, "Error opening sequence %s\n", m_sequenceName.c_str());
@@ -96,6 +99,19 @@ int PlaylistEntrySequence::StartPlaying(void)
 	return PlaylistEntryBase::StartPlaying();
 }
 
+/*
+ * Open the sequence and read the first frames in the background so
+ * it can start without a gap when the previous entry finishes
+ */
+int PlaylistEntrySequence::Prep(void)
+{
+	LogDebug(VB_PLAYLIST, "PlaylistEntrySequence::Prep()\n");
+
+	sequence->PrepareSequenceFile(m_sequenceName.c_str());
+
+	return PlaylistEntryBase::Prep();
+}
+
 /*
  *
  */
@@ -38,6 +38,7 @@ class PlaylistEntrySequence : public PlaylistEntryBase {
 	int  Init(Json::Value &config);
 
 	int  StartPlaying(void);
+	int  Prep(void);
 	int  Process(void);
 	int  Stop(void);
 
@@ -0,0 +1,7 @@
+#!/bin/bash
+#
+# Install lz4 libraries needed for lz4 compressed fseq files
+#
+
+apt-get -y update
+apt-get -y install liblz4-dev
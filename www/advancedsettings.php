@@ -106,6 +106,11 @@ function flashEMMCBtrfs() {
 				outputting. <font color='#ff0000'><b>WARNING</b></font> - Some
 				output devices such as the FPD do not support rates other than 50ms.</td>
 		</tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("BridgeRecordMaxMinutes", 1, 0, 4, 4, "", "60"); ?> minutes</td>
+			<td valign='top'><b>Bridge Recording Maximum Length</b> - Bridge
+				mode data can be recorded into a sequence through the fppd/bridge/record
+				API.  Recordings stop automatically after this many minutes.</td>
+		</tr>
 		<tr><td colspan='2'><hr></td></tr>
 		<tr><td valign='top'><? PrintSettingSelect("Boot Delay", "bootDelay", 0, 0, "0", Array('0s' => '0', '1s' => '1', '2s' => '2', '3s' => '3', '4s' => '4', '5s' => '5', '6s' => '6', '7s' => '7', '8s' => '8', '9s' => '9', '10s' => '10', '15s' => '10', '20s' => '20', '25s' => '25', '30s' => '30')); ?></td>
 			<td valign='top'><b>Boot Delay</b> - The time that FPP waits after
@@ -117,6 +122,117 @@ function flashEMMCBtrfs() {
 				give the network switches and routers time to fully start up.</td>
 		</tr>
 		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingCheckbox("Memory Map Sequences", "mmapSequenceFiles", 0, 0, "1", "0"); ?> Memory Map Sequences</td>
+			<td valign='top'><b>Memory Map Sequences</b> - Read uncompressed
+				sequence files through a memory mapping instead of normal file
+				reads.  Frame data is copied directly out of the page cache which
+				reduces the CPU and memory overhead of reading large sequences.
+				Compressed sequences are not affected by this setting.  Takes
+				effect the next time a sequence is started.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("SequenceReadAheadMS", 0, 0, 5, 5, "", "1000"); ?> ms<br>
+				<? PrintSettingTextSaved("SequenceReadAheadMaxMB", 0, 0, 5, 5, "", "64"); ?> MB</td>
+			<td valign='top'><b>Sequence Read-Ahead</b> - How far ahead of
+				playback fppd tries to keep sequence frames read and decoded,
+				and the most memory it will use to do so.  The read-ahead is
+				increased automatically when reading or decompressing frames
+				is slow or frames are not ready in time.  The current
+				read-ahead and underrun count are shown in the fppd status.
+				Takes effect the next time a sequence is started.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("SequenceWarmStartMS", 0, 0, 5, 5, "", "1000"); ?> ms</td>
+			<td valign='top'><b>Sequence Warm Start</b> - While a playlist
+				entry is playing, the next sequence in the playlist is opened
+				and this much of it is read in the background so it starts
+				without a gap.  Set to -1 to disable.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("FSEQCacheMB", 0, 0, 5, 5, "", "0"); ?> MB</td>
+			<td valign='top'><b>Sequence Cache</b> - Memory used to keep the
+				compressed data of recently played sequences so looping
+				sequences are not read from the SD card every time.  The least
+				recently used data is dropped first.  0 disables the cache.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingSelect("Sequence Transcode", "SequenceTranscode", 0, 0, "zstd", Array('zstd' => 'zstd', 'LZ4' => 'lz4', 'Uncompressed' => 'none', 'Disabled' => 'off')); ?></td>
+			<td valign='top'><b>Sequence Transcode</b> - V1 and zlib compressed
+				sequences, and sequences where only a small part of the channels
+				are output, are converted in the background the first time they
+				are played.  The copy only has the channels this FPP outputs and
+				is stored in the media cache directory and used from then on.
+				The original sequence is not changed.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingSelect("Sequence Frame Interpolation", "SequenceInterpolation", 1, 0, "1", Array('Disabled' => '1', '2x' => '2', '3x' => '3', '4x' => '4')); ?></td>
+			<td valign='top'><b>Sequence Frame Interpolation</b> - Output
+				this many frames for every sequence frame.  The extra frames are
+				blended between the sequence frames so fades look smoother
+				without rendering the sequence at a higher rate.  Frames are
+				never sent closer than 10ms apart.</td>
+		</tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("SequenceInterpolationGamma", 1, 0, 4, 4, "", ""); ?></td>
+			<td valign='top'><b>Sequence Interpolation Gamma</b> - Blend the
+				interpolated frames in linear light using this gamma, for
+				example 2.2.  Leave blank to blend the channel values directly.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("OutputRangeMergeGap", 1, 0, 6, 6, "", "1024"); ?> channels</td>
+			<td valign='top'><b>Output Range Merge Gap</b> - Only the channel
+				ranges used by the configured outputs are read from sequences
+				and cleared between frames.  Ranges closer together than this
+				are read as a single range.  -1 only merges touching ranges.</td>
+		</tr>
+		<tr><td valign='top'><? PrintSettingCheckbox("Output Pipeline", "ChannelOutputPipeline", 1, 0, "1", "0"); ?> Output Pipeline</td>
+			<td valign='top'><b>Output Pipeline</b> - Prepare and send each
+				frame on a separate thread while the next frame is read and
+				overlaid.  This helps when slow outputs such as large matrices
+				or many network controllers don't fit in the frame time.  The
+				outputs run one frame behind, which is made up for when
+				syncing to media and to other FPP systems.</td>
+		</tr>
+		<tr><td valign='top'><? PrintSettingSelect("Output Prep Threads", "ChannelOutputPrepThreads", 1, 0, "0", Array('Auto' => '0', 'Disabled' => '1', '2' => '2', '3' => '3', '4' => '4', '8' => '8')); ?></td>
+			<td valign='top'><b>Output Prep Threads</b> - Number of CPU
+				cores used to prepare the channel outputs each frame.  Outputs
+				and the rows of LED panel matrices are prepared in parallel.
+				Auto uses all the cores.  The time each output takes is logged
+				at the debug level for Channel Outputs.</td>
+		</tr>
+		<tr><td valign='top'><? PrintSettingSelect("Unchanged Data Keep Alive", "UnchangedDataKeepAlive", 1, 0, "0", Array('Disabled' => '0', '250ms' => '250', '500ms' => '500', '1 second' => '1000', '2 seconds' => '2000', '5 seconds' => '5000')); ?></td>
+			<td valign='top'><b>Unchanged Data Keep Alive</b> - Only send
+				network outputs and universes when their channels change,
+				resending unchanged data at this interval.  Changed data is
+				repeated for a few frames in case packets are lost.  E1.31,
+				Art-Net and DDP universes are resent at least every 1, 2 and 2
+				seconds.  Serial and local outputs are always sent every frame.
+				Disabled sends every output every frame.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
+		<tr><td valign='top'><? PrintSettingSelect("Playback Thread Scheduling", "PlaybackThreadScheduling", 1, 0, "", Array('Normal' => '', 'Real Time FIFO' => 'FIFO', 'Real Time Round Robin' => 'RR')); ?></td>
+			<td valign='top'><b>Playback Thread Scheduling</b> - Run the
+				channel output, sequence reading and media decoding threads at
+				real time priority so they aren't delayed by the web interface
+				and other background work.</td>
+		</tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("OutputThreadPriority", 1, 0, 2, 2, "", "50"); ?>
+			<? PrintSettingTextSaved("ReadThreadPriority", 1, 0, 2, 2, "", "40"); ?>
+			<? PrintSettingTextSaved("MediaThreadPriority", 1, 0, 2, 2, "", "30"); ?></td>
+			<td valign='top'><b>Playback Thread Priorities</b> - Real time
+				priorities from 1 to 99 for the output, sequence read and media
+				decode threads.</td>
+		</tr>
+		<tr><td valign='top'><? PrintSettingTextSaved("PlaybackThreadCPUs", 1, 0, 16, 8, "", ""); ?></td>
+			<td valign='top'><b>Playback Thread CPUs</b> - CPU cores the
+				playback threads may run on, for example "2,3" or "1-3".  Leave
+				blank to use any core.</td>
+		</tr>
+		<tr><td valign='top'><? PrintSettingCheckbox("Lock Playback Memory", "LockPlaybackMemory", 1, 0, "1", "0"); ?> Lock Memory</td>
+			<td valign='top'><b>Lock Playback Memory</b> - Keep fppd's memory
+				from being swapped out so frames aren't delayed by page faults
+				during a show.</td>
+		</tr>
+		<tr><td colspan='2'><hr></td></tr>
 <?
 	if ($settings['fppMode'] != 'remote')
 	{